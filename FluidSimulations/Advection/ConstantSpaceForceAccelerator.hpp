@@ -1,7 +1,9 @@
 #pragma once
 
 #include "../IMovement.hpp"
-#include "../GridDefinitions.hpp"
+#include "../GridOperations.hpp"
+#include "../MacVelocityGrid.hpp"
+#include "../ParallelGridOperations.hpp"
 #include "../ScalarVectorOperations.hpp"
 
 namespace FluidSimulations
@@ -15,10 +17,19 @@ public:
     typedef std::shared_ptr<const FloatsThreeDVector> AccelerationVectorConstPtr;
 
     ConstantSpaceForceAccelerator(
-        const FloatsThreeDVectorGridPtr& velocity, 
+        const MacVelocityGridPtr& velocity, 
         const AccelerationVectorConstPtr& acceleration)
+        : ConstantSpaceForceAccelerator(velocity, acceleration, std::make_shared<TaskScheduler>(1))
+    {
+    }
+
+    ConstantSpaceForceAccelerator(
+        const MacVelocityGridPtr& velocity,
+        const AccelerationVectorConstPtr& acceleration,
+        const TaskSchedulerPtr& scheduler)
         : m_velocity(velocity)
         , m_acceleration(acceleration)
+        , m_scheduler(scheduler)
     {
     }
 
@@ -26,21 +37,31 @@ public:
     {
         const FloatsThreeDVector offset = multiply(*m_acceleration, timeInterval);
 
-        for (IntegerType i = 0; i < m_velocity->iRes(); ++i)
+        accelerateComponent(m_velocity->iComponent(), offset.x);
+        accelerateComponent(m_velocity->jComponent(), offset.y);
+        accelerateComponent(m_velocity->kComponent(), offset.z);
+    }
+
+private:
+    void accelerateComponent(const FloatsGridPtr& component, const FloatType offset) const
+    {
+        if (offset == 0)
         {
-            for (IntegerType j = 0; j < m_velocity->jRes(); ++j)
-            {
-                for (IntegerType k = 0; k < m_velocity->kRes(); ++k)
-                {
-                    sumIn(m_velocity->at(i, j, k), offset);
-                }
-            }
+            return;
         }
+
+        FloatsGrid& grid = *component;
+
+        parallelForEachIndex(*m_scheduler, grid, [&grid, offset](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            grid.at(i, j, k) += offset;
+        });
     }
 
 private:
-    const FloatsThreeDVectorGridPtr m_velocity;
+    const MacVelocityGridPtr m_velocity;
     const AccelerationVectorConstPtr m_acceleration;
+    const TaskSchedulerPtr m_scheduler;
 };
 
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "../IMovement.hpp"
+#include "../GridArena.hpp"
 #include "../GridOperations.hpp"
+#include "../ParallelGridOperations.hpp"
 
 namespace FluidSimulations
 {
@@ -9,31 +11,60 @@ namespace FluidSimulations
 namespace Advection
 {
 
-template <typename FloatsSpaceType, typename LagrangeTrackerType>
+// Cells are traced back and sampled independently on the threads of the scheduler,
+// the approximator and the tracker are only read meanwhile.
+
+template <typename FloatsSpaceType, typename LagrangeTrackerType, typename FloatsGridType = FloatsGrid>
 class LagrangeFieldAdvector
     : public IMovement
 {
 public:
+    typedef std::shared_ptr<FloatsGridType> FloatsGridTypePtr;
+
     LagrangeFieldAdvector(
-        const FloatsGridPtr& targetGrid,
+        const FloatsGridTypePtr& targetGrid,
         const FloatsSpaceType& targetApproximator, 
         const LagrangeTrackerType& lagrangeTracker)
+        : LagrangeFieldAdvector(targetGrid, targetApproximator, lagrangeTracker, std::make_shared<GridArena>())
+    {
+    }
+
+    LagrangeFieldAdvector(
+        const FloatsGridTypePtr& targetGrid,
+        const FloatsSpaceType& targetApproximator,
+        const LagrangeTrackerType& lagrangeTracker,
+        const GridArenaPtr& arena)
+        : LagrangeFieldAdvector(targetGrid, targetApproximator, lagrangeTracker, arena, std::make_shared<TaskScheduler>(1))
+    {
+    }
+
+    LagrangeFieldAdvector(
+        const FloatsGridTypePtr& targetGrid,
+        const FloatsSpaceType& targetApproximator,
+        const LagrangeTrackerType& lagrangeTracker,
+        const GridArenaPtr& arena,
+        const TaskSchedulerPtr& scheduler)
         : m_targetGrid(targetGrid)
-        , m_bufferGrid(std::make_shared<FloatsGrid>(targetGrid->iRes(), targetGrid->jRes(), targetGrid->kRes()))
         , m_targetGridApproximator(targetApproximator)
         , m_lagrangeTracker(lagrangeTracker)
+        , m_arena(arena)
+        , m_scheduler(scheduler)
     {
     }
 
+    // The buffer has to match the target in resolution and halo, their values are
+    // swapped after every move.
+
     LagrangeFieldAdvector(
-        const FloatsGridPtr& targetGrid, 
-        const FloatsGridPtr& bufferGrid,
+        const FloatsGridTypePtr& targetGrid, 
+        const FloatsGridTypePtr& bufferGrid,
         const FloatsSpaceType& targetApproximator, 
         const LagrangeTrackerType& lagrangeTracker)
         : m_targetGrid(targetGrid)
         , m_bufferGrid(bufferGrid)
         , m_targetGridApproximator(targetApproximator)
         , m_lagrangeTracker(lagrangeTracker)
+        , m_scheduler(std::make_shared<TaskScheduler>(1))
     {
     }
 
@@ -42,27 +73,29 @@ public:
 
     virtual void move(const FloatType timeInterval) override
     {
-        for (IntegerType i = 0; i < m_bufferGrid->iRes(); ++i)
+        const FloatsGridTypePtr bufferGridPtr = m_bufferGrid ? m_bufferGrid : m_arena->checkOutLike(*m_targetGrid);
+        FloatsGridType& bufferGrid = *bufferGridPtr;
+
+        copyTopology(*m_targetGrid, bufferGrid);
+        dilateTopology(bufferGrid);
+
+        parallelForEachIndex(*m_scheduler, bufferGrid, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
         {
-            for (IntegerType j = 0; j < m_bufferGrid->jRes(); ++j)
-            {
-                for (IntegerType k = 0; k < m_bufferGrid->kRes(); ++k)
-                {
-                    const FloatsThreeDVector position = FloatsThreeDVector(static_cast<FloatType>(i), static_cast<FloatType>(j), static_cast<FloatType>(k));
-                    const FloatsThreeDVector previousPosition = m_lagrangeTracker.traceBack(position, timeInterval);
-                    m_bufferGrid->at(i, j, k) = m_targetGridApproximator.at(previousPosition.x, previousPosition.y, previousPosition.z);
-                }
-            }
-        }
-
-        copyIn<FloatType>(m_bufferGrid, m_targetGrid);
+            const FloatsThreeDVector position = FloatsThreeDVector(static_cast<FloatType>(i), static_cast<FloatType>(j), static_cast<FloatType>(k));
+            const FloatsThreeDVector previousPosition = m_lagrangeTracker.traceBack(position, timeInterval);
+            bufferGrid.at(i, j, k) = m_targetGridApproximator.at(previousPosition.x, previousPosition.y, previousPosition.z);
+        });
+
+        m_targetGrid->swap(bufferGrid);
     }
 
 private:
-    const FloatsGridPtr m_targetGrid;
-    const FloatsGridPtr m_bufferGrid;
+    const FloatsGridTypePtr m_targetGrid;
+    const FloatsGridTypePtr m_bufferGrid;
     const FloatsSpaceType m_targetGridApproximator;
     const LagrangeTrackerType m_lagrangeTracker;
+    const GridArenaPtr m_arena;
+    const TaskSchedulerPtr m_scheduler;
 };
 
 }
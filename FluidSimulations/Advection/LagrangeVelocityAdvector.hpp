@@ -1,7 +1,11 @@
 #pragma once
 
 #include "../IMovement.hpp"
+#include "../GridArena.hpp"
 #include "../GridOperations.hpp"
+#include "../MacVelocityGrid.hpp"
+#include "../ParallelGridOperations.hpp"
+#include "../ScalarVectorOperations.hpp"
 
 namespace FluidSimulations
 {
@@ -9,31 +13,59 @@ namespace FluidSimulations
 namespace Advection
 {
 
+// Faces of a component are advected in parallel like in LagrangeFieldAdvector. All the
+// components are traced through the velocity of the start of the move, so they are
+// advected into buffers and swapped into place together at the end.
+
 template <typename FloatsThreeDVectorSpaceType, typename LagrangeTrackerType>
 class LagrangeVelocityAdvector
     : public IMovement
 {
 public:
     LagrangeVelocityAdvector(
-        const FloatsThreeDVectorGridPtr& targetVelocityGrid,
+        const MacVelocityGridPtr& targetVelocityGrid,
         const FloatsThreeDVectorSpaceType& velocityApproximator, 
         const LagrangeTrackerType& lagrangeTracker)
+        : LagrangeVelocityAdvector(targetVelocityGrid, velocityApproximator, lagrangeTracker, std::make_shared<GridArena>())
+    {
+    }
+
+    LagrangeVelocityAdvector(
+        const MacVelocityGridPtr& targetVelocityGrid,
+        const FloatsThreeDVectorSpaceType& velocityApproximator,
+        const LagrangeTrackerType& lagrangeTracker,
+        const GridArenaPtr& arena)
+        : LagrangeVelocityAdvector(targetVelocityGrid, velocityApproximator, lagrangeTracker, arena, std::make_shared<TaskScheduler>(1))
+    {
+    }
+
+    LagrangeVelocityAdvector(
+        const MacVelocityGridPtr& targetVelocityGrid,
+        const FloatsThreeDVectorSpaceType& velocityApproximator,
+        const LagrangeTrackerType& lagrangeTracker,
+        const GridArenaPtr& arena,
+        const TaskSchedulerPtr& scheduler)
         : m_targetVelocityGrid(targetVelocityGrid)
-        , m_bufferVelocityGrid(std::make_shared<FloatsThreeDVectorGrid>(targetVelocityGrid->iRes(), targetVelocityGrid->jRes(), targetVelocityGrid->kRes()))
         , m_velocityApproximator(velocityApproximator)
         , m_lagrangeTracker(lagrangeTracker)
+        , m_arena(arena)
+        , m_scheduler(scheduler)
     {
     }
 
+    // The buffer has to match the target in resolution and halo, their values are
+    // swapped after every move.
+
     LagrangeVelocityAdvector(
-        const FloatsThreeDVectorGridPtr& targetVelocityGrid, 
-        const FloatsThreeDVectorGridPtr& bufferVelocityGrid, 
+        const MacVelocityGridPtr& targetVelocityGrid, 
+        const MacVelocityGridPtr& bufferVelocityGrid, 
         const FloatsThreeDVectorSpaceType& velocityApproximator, 
         const LagrangeTrackerType& lagrangeTracker)
         : m_targetVelocityGrid(targetVelocityGrid)
         , m_bufferVelocityGrid(bufferVelocityGrid)
         , m_velocityApproximator(velocityApproximator)
         , m_lagrangeTracker(lagrangeTracker)
+        , m_scheduler(std::make_shared<TaskScheduler>(1))
     {
     }
 
@@ -42,37 +74,48 @@ public:
 
     virtual void move(const FloatType timeInterval) override
     {
-        for (IntegerType i = 0; i < m_bufferVelocityGrid->iRes(); ++i)
+        const FloatsGridPtr iBuffer = bufferComponent(&MacVelocityGrid::iComponent);
+        const FloatsGridPtr jBuffer = bufferComponent(&MacVelocityGrid::jComponent);
+        const FloatsGridPtr kBuffer = bufferComponent(&MacVelocityGrid::kComponent);
+
+        advectComponent(*iBuffer, FloatsThreeDVector(-0.5f, 0, 0), &FloatsThreeDVector::x, timeInterval);
+        advectComponent(*jBuffer, FloatsThreeDVector(0, -0.5f, 0), &FloatsThreeDVector::y, timeInterval);
+        advectComponent(*kBuffer, FloatsThreeDVector(0, 0, -0.5f), &FloatsThreeDVector::z, timeInterval);
+
+        m_targetVelocityGrid->iComponent()->swap(*iBuffer);
+        m_targetVelocityGrid->jComponent()->swap(*jBuffer);
+        m_targetVelocityGrid->kComponent()->swap(*kBuffer);
+    }
+
+private:
+    FloatsGridPtr bufferComponent(const FloatsGridPtr& (MacVelocityGrid::* component)()) const
+    {
+        if (m_bufferVelocityGrid)
         {
-            for (IntegerType j = 0; j < m_bufferVelocityGrid->jRes(); ++j)
-            {
-                for (IntegerType k = 0; k < m_bufferVelocityGrid->kRes(); ++k)
-                {
-                    const FloatsThreeDVector iPosition = FloatsThreeDVector(static_cast<FloatType>(i) - 0.5f, static_cast<FloatType>(j), static_cast<FloatType>(k));
-                    const FloatsThreeDVector iPreviousPosition = m_lagrangeTracker.traceBack(iPosition, timeInterval);
-                    const FloatType iPreviousSpeed = m_velocityApproximator.at(iPreviousPosition.x, iPreviousPosition.y, iPreviousPosition.z).x;
-
-                    const FloatsThreeDVector jPosition = FloatsThreeDVector(static_cast<FloatType>(i), static_cast<FloatType>(j) - 0.5f, static_cast<FloatType>(k));
-                    const FloatsThreeDVector jPreviousPosition = m_lagrangeTracker.traceBack(jPosition, timeInterval);
-                    const FloatType jPreviousSpeed = m_velocityApproximator.at(jPreviousPosition.x, jPreviousPosition.y, jPreviousPosition.z).y;
-
-                    const FloatsThreeDVector kPosition = FloatsThreeDVector(static_cast<FloatType>(i), static_cast<FloatType>(j), static_cast<FloatType>(k) - 0.5f);
-                    const FloatsThreeDVector kPreviousPosition = m_lagrangeTracker.traceBack(kPosition, timeInterval);
-                    const FloatType kPreviousSpeed = m_velocityApproximator.at(kPreviousPosition.x, kPreviousPosition.y, kPreviousPosition.z).z;
-
-                    m_bufferVelocityGrid->at(i, j, k) = FloatsThreeDVector(iPreviousSpeed, jPreviousSpeed, kPreviousSpeed);
-                }
-            }
+            return ((*m_bufferVelocityGrid).*component)();
         }
 
-        copyIn<FloatsThreeDVector>(m_bufferVelocityGrid, m_targetVelocityGrid);
+        return m_arena->checkOutLike(*((*m_targetVelocityGrid).*component)());
+    }
+
+    void advectComponent(FloatsGrid& buffer, const FloatsThreeDVector& faceOffset,
+        FloatType FloatsThreeDVector::* component, const FloatType timeInterval)
+    {
+        parallelForEachIndex(*m_scheduler, buffer, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            const FloatsThreeDVector position = sum(FloatsThreeDVector(static_cast<FloatType>(i), static_cast<FloatType>(j), static_cast<FloatType>(k)), faceOffset);
+            const FloatsThreeDVector previousPosition = m_lagrangeTracker.traceBack(position, timeInterval);
+            buffer.at(i, j, k) = m_velocityApproximator.at(previousPosition.x, previousPosition.y, previousPosition.z).*component;
+        });
     }
 
 private:
-    const FloatsThreeDVectorGridPtr m_targetVelocityGrid;
-    const FloatsThreeDVectorGridPtr m_bufferVelocityGrid;
+    const MacVelocityGridPtr m_targetVelocityGrid;
+    const MacVelocityGridPtr m_bufferVelocityGrid;
     const FloatsThreeDVectorSpaceType m_velocityApproximator;
     const LagrangeTrackerType m_lagrangeTracker;
+    const GridArenaPtr m_arena;
+    const TaskSchedulerPtr m_scheduler;
 };
 
 }
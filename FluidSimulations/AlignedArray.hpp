@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace FluidSimulations
+{
+
+template <typename ValueType>
+class AlignedArray
+{
+public:
+    static const std::size_t alignment = 64;
+
+    explicit AlignedArray(const std::size_t size)
+        : AlignedArray(size, std::shared_ptr<char>(new char[requiredMemory(size)], std::default_delete<char[]>()))
+    {
+    }
+
+    // The memory has to hold at least requiredMemory(size) bytes.
+
+    AlignedArray(const std::size_t size, const std::shared_ptr<char>& memory)
+        : m_size(size)
+        , m_memory(memory)
+        , m_data(alignPointer(m_memory.get()))
+    {
+        for (std::size_t index = 0; index != m_size; ++index)
+        {
+            new (m_data + index) ValueType;
+        }
+    }
+
+    AlignedArray(const AlignedArray&) = delete;
+    AlignedArray& operator=(const AlignedArray&) = delete;
+
+    ~AlignedArray()
+    {
+        for (std::size_t index = 0; index != m_size; ++index)
+        {
+            m_data[index].~ValueType();
+        }
+    }
+
+    static inline std::size_t requiredMemory(const std::size_t size)
+    {
+        return size * sizeof(ValueType) + alignment;
+    }
+
+    inline std::size_t size() const
+    {
+        return m_size;
+    }
+
+    inline ValueType* data()
+    {
+        return m_data;
+    }
+
+    inline const ValueType* data() const
+    {
+        return m_data;
+    }
+
+    inline void swap(AlignedArray& other)
+    {
+        std::swap(m_size, other.m_size);
+        std::swap(m_memory, other.m_memory);
+        std::swap(m_data, other.m_data);
+    }
+
+    inline ValueType& operator[](const std::size_t index)
+    {
+        return m_data[index];
+    }
+
+    inline const ValueType& operator[](const std::size_t index) const
+    {
+        return m_data[index];
+    }
+
+private:
+    static inline ValueType* alignPointer(char* memory)
+    {
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(memory);
+        const std::uintptr_t alignedAddress = (address + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+
+        return reinterpret_cast<ValueType*>(memory + (alignedAddress - address));
+    }
+
+private:
+    std::size_t m_size;
+    std::shared_ptr<char> m_memory;
+    ValueType* m_data;
+};
+
+}
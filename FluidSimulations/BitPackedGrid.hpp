@@ -0,0 +1,252 @@
+#pragma once
+
+#include "AlignedArray.hpp"
+#include "Grid.hpp"
+#include "GridHalo.hpp"
+#include "GridLayouts.hpp"
+#include "ScalarVectorDefinitions.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace FluidSimulations
+{
+
+// Bits of a 7-point stencil mask, see Grid<bool>::stencilMask.
+
+const std::uint32_t stencilCenterBit = 1 << 0;
+const std::uint32_t stencilIMinusBit = 1 << 1;
+const std::uint32_t stencilIPlusBit = 1 << 2;
+const std::uint32_t stencilJMinusBit = 1 << 3;
+const std::uint32_t stencilJPlusBit = 1 << 4;
+const std::uint32_t stencilKMinusBit = 1 << 5;
+const std::uint32_t stencilKPlusBit = 1 << 6;
+
+const std::uint32_t stencilNeighboursBits = stencilIMinusBit | stencilIPlusBit
+    | stencilJMinusBit | stencilJPlusBit | stencilKMinusBit | stencilKPlusBit;
+
+// Predicate grid with one bit per cell. Every row along k, halo included, starts
+// a new 64-bit word, so rows can be cleared and read a word at a time.
+// The storage is linear whatever the layout of the other grids is.
+
+template <typename LayoutType>
+class Grid<bool, LayoutType>
+{
+public:
+    typedef std::uint64_t Word;
+
+    static const IntegerType wordBits = 64;
+
+    template <typename OtherValueType>
+    using Rebind = Grid<OtherValueType, LayoutType>;
+
+    class BitReference
+    {
+    public:
+        BitReference(Word& word, const Word mask)
+            : m_word(word)
+            , m_mask(mask)
+        {}
+
+        inline operator bool() const
+        {
+            return (m_word & m_mask) != 0;
+        }
+
+        inline BitReference& operator=(const bool value)
+        {
+            m_word = value ? (m_word | m_mask) : (m_word & ~m_mask);
+
+            return *this;
+        }
+
+        inline BitReference& operator=(const BitReference& other)
+        {
+            return *this = static_cast<bool>(other);
+        }
+
+    private:
+        Word& m_word;
+        const Word m_mask;
+    };
+
+    Grid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes)
+        : Grid(iRes, jRes, kRes, GridHalo(0))
+    {
+    }
+
+    Grid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const bool defaultValue)
+        : Grid(iRes, jRes, kRes, GridHalo(0), defaultValue)
+    {
+    }
+
+    Grid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const GridHalo& halo)
+        : m_iRes(iRes)
+        , m_jRes(jRes)
+        , m_kRes(kRes)
+        , m_halo(halo.width())
+        , m_layout(iRes + 2 * m_halo, jRes + 2 * m_halo, kRes + 2 * m_halo)
+        , m_rowWords(rowWords(kRes, halo))
+        , m_words(wordsCount(iRes, jRes, kRes, halo))
+    {
+    }
+
+    Grid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const GridHalo& halo, const std::shared_ptr<char>& memory)
+        : m_iRes(iRes)
+        , m_jRes(jRes)
+        , m_kRes(kRes)
+        , m_halo(halo.width())
+        , m_layout(iRes + 2 * m_halo, jRes + 2 * m_halo, kRes + 2 * m_halo)
+        , m_rowWords(rowWords(kRes, halo))
+        , m_words(wordsCount(iRes, jRes, kRes, halo), memory)
+    {
+    }
+
+    Grid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const GridHalo& halo, const bool defaultValue)
+        : Grid(iRes, jRes, kRes, halo)
+    {
+        fill(defaultValue);
+    }
+
+    static inline std::size_t requiredMemory(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const GridHalo& halo)
+    {
+        return AlignedArray<Word>::requiredMemory(wordsCount(iRes, jRes, kRes, halo));
+    }
+
+    Grid(const Grid&) = delete;
+    Grid& operator=(const Grid&) = delete;
+
+    inline const IntegerType& iRes() const
+    {
+        return m_iRes;
+    }
+
+    inline const IntegerType& jRes() const
+    {
+        return m_jRes;
+    }
+
+    inline const IntegerType& kRes() const
+    {
+        return m_kRes;
+    }
+
+    inline IntegersThreeDVector res() const
+    {
+        return IntegersThreeDVector(iRes(), jRes(), kRes());
+    }
+
+    inline const IntegerType& halo() const
+    {
+        return m_halo;
+    }
+
+    inline const LinearGridLayout& layout() const
+    {
+        return m_layout;
+    }
+
+    inline IntegerType wordsCount() const
+    {
+        return static_cast<IntegerType>(m_words.size());
+    }
+
+    inline Word* words()
+    {
+        return m_words.data();
+    }
+
+    inline const Word* words() const
+    {
+        return m_words.data();
+    }
+
+    inline void swap(Grid& other)
+    {
+        assert(m_iRes == other.m_iRes && m_jRes == other.m_jRes && m_kRes == other.m_kRes);
+        assert(m_halo == other.m_halo);
+
+        m_words.swap(other.m_words);
+    }
+
+    inline BitReference at(const IntegerType i, const IntegerType j, const IntegerType k)
+    {
+        const IntegerType bit = k + m_halo;
+
+        return BitReference(m_words[rowOffset(i, j) + (bit >> 6)], Word(1) << (bit & (wordBits - 1)));
+    }
+
+    inline bool at(const IntegerType i, const IntegerType j, const IntegerType k) const
+    {
+        const IntegerType bit = k + m_halo;
+
+        return ((m_words[rowOffset(i, j) + (bit >> 6)] >> (bit & (wordBits - 1))) & 1) != 0;
+    }
+
+    void fill(const bool value)
+    {
+        std::memset(m_words.data(), value ? 0xff : 0, m_words.size() * sizeof(Word));
+    }
+
+    // The cell and its six face neighbours as stencil bits, the halo has to be at least
+    // one cell wide to ask for the border cells.
+
+    inline std::uint32_t stencilMask(const IntegerType i, const IntegerType j, const IntegerType k) const
+    {
+        const IntegerType bit = k + m_halo;
+        const IntegerType word = rowOffset(i, j) + (bit >> 6);
+        const IntegerType shift = bit & (wordBits - 1);
+
+        const Word row = m_words[word] >> shift;
+
+        std::uint32_t mask = static_cast<std::uint32_t>(row & 1);
+
+        mask |= static_cast<std::uint32_t>(shift == wordBits - 1 ? m_words[word + 1] & 1 : (row >> 1) & 1) << 6;
+        mask |= static_cast<std::uint32_t>(shift == 0 ? m_words[word - 1] >> (wordBits - 1) : (m_words[word] >> (shift - 1)) & 1) << 5;
+
+        mask |= static_cast<std::uint32_t>((m_words[word - m_rowWords * (m_jRes + 2 * m_halo)] >> shift) & 1) << 1;
+        mask |= static_cast<std::uint32_t>((m_words[word + m_rowWords * (m_jRes + 2 * m_halo)] >> shift) & 1) << 2;
+        mask |= static_cast<std::uint32_t>((m_words[word - m_rowWords] >> shift) & 1) << 3;
+        mask |= static_cast<std::uint32_t>((m_words[word + m_rowWords] >> shift) & 1) << 4;
+
+        return mask;
+    }
+
+private:
+    static inline IntegerType rowWords(const IntegerType kRes, const GridHalo& halo)
+    {
+        return (kRes + 2 * halo.width() + wordBits - 1) / wordBits;
+    }
+
+    static inline std::size_t wordsCount(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const GridHalo& halo)
+    {
+        return static_cast<std::size_t>(iRes + 2 * halo.width()) * (jRes + 2 * halo.width()) * rowWords(kRes, halo);
+    }
+
+    inline IntegerType rowOffset(const IntegerType i, const IntegerType j) const
+    {
+        return ((i + m_halo) * (m_jRes + 2 * m_halo) + j + m_halo) * m_rowWords;
+    }
+
+private:
+    const IntegerType m_iRes;
+    const IntegerType m_jRes;
+    const IntegerType m_kRes;
+    const IntegerType m_halo;
+
+    const LinearGridLayout m_layout;
+
+    const IntegerType m_rowWords;
+
+    AlignedArray<Word> m_words;
+};
+
+}
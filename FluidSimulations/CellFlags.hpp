@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Grid.hpp"
+
+#include <cstdint>
+#include <memory>
+
+namespace FluidSimulations
+{
+
+// Classification of grid cells, a cell which is neither fluid nor solid is air.
+
+typedef std::uint8_t CellFlags;
+
+const CellFlags fluidCellFlag = 1;
+const CellFlags solidCellFlag = 2;
+
+typedef Grid<CellFlags> CellFlagsGrid;
+typedef std::shared_ptr<CellFlagsGrid> CellFlagsGridPtr;
+typedef std::shared_ptr<const CellFlagsGrid> CellFlagsGridConstPtr;
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CellFlags.hpp"
+
+namespace FluidSimulations
+{
+
+// Predicate space over a classified cells grid, true where the masked flags of a cell
+// equal the expected ones. Cells are addressed by integer indices, the halo of the
+// grid answers for the neighbours of the border cells.
+
+class CellFlagsPredicate
+{
+public:
+    CellFlagsPredicate(const CellFlagsGridConstPtr& cellFlags, const CellFlags mask, const CellFlags expected)
+        : m_cellFlags(cellFlags)
+        , m_mask(mask)
+        , m_expected(expected)
+    {
+    }
+
+    static inline CellFlagsPredicate fluid(const CellFlagsGridConstPtr& cellFlags)
+    {
+        return CellFlagsPredicate(cellFlags, fluidCellFlag, fluidCellFlag);
+    }
+
+    static inline CellFlagsPredicate solid(const CellFlagsGridConstPtr& cellFlags)
+    {
+        return CellFlagsPredicate(cellFlags, solidCellFlag, solidCellFlag);
+    }
+
+    static inline CellFlagsPredicate air(const CellFlagsGridConstPtr& cellFlags)
+    {
+        return CellFlagsPredicate(cellFlags, fluidCellFlag | solidCellFlag, 0);
+    }
+
+    inline bool at(const IntegerType i, const IntegerType j, const IntegerType k) const
+    {
+        return (m_cellFlags->at(i, j, k) & m_mask) == m_expected;
+    }
+
+private:
+    const CellFlagsGridConstPtr m_cellFlags;
+    const CellFlags m_mask;
+    const CellFlags m_expected;
+};
+
+}
@@ -1,16 +1,26 @@
 #pragma once
 
 #include "AirPredicate.hpp"
+#include "BitPackedGrid.hpp"
+#include "CellFlags.hpp"
+#include "CellFlagsPredicate.hpp"
 #include "ConstantSpace.hpp"
 #include "ScalarVectorOperations.hpp"
 #include "GradientCalculator.hpp"
+#include "GridArena.hpp"
+#include "GridHalo.hpp"
 #include "GridOperations.hpp"
 #include "IMovement.hpp"
 #include "ISimulator.hpp"
 #include "LinearFloatsGridApproximator.hpp"
 #include "LinearObjectVelocityGridApproximator.hpp"
+#include "MacVelocityGrid.hpp"
+#include "ParallelGridOperations.hpp"
 #include "RigidGridBoundary.hpp"
 #include "RigidGridBoundaryPredicate.hpp"
+#include "SimdLevel.hpp"
+#include "SparseGrid.hpp"
+#include "TaskScheduler.hpp"
 #include "VelocitySpaceRigidBoundary.hpp"
 
 #include "Advection\ConstantSpaceForceAccelerator.hpp"
@@ -20,14 +30,30 @@
 
 #include "Machinery\CflConditionTimeSuggester.hpp"
 #include "Machinery\ConstantTimeSimulator.hpp"
+#include "Machinery\StepTimeBudget.hpp"
 #include "Machinery\SuggestedTimeSimulator.hpp"
 
 #include "SignedDistanceField\InteriorPredicate.hpp"
+#include "SignedDistanceField\NarrowBandOperations.hpp"
 #include "SignedDistanceField\NearestSurfacePointCalculator.hpp"
 #include "SignedDistanceField\SignedDistanceGridApproximatorExtension.hpp"
 #include "SignedDistanceField\SignedDistanceMovement.hpp"
 #include "SignedDistanceField\SignedDistanceSweeper.hpp"
 
+#include "Projection\ActiveCellsList.hpp"
+#include "Projection\CellClassificationMovement.hpp"
+#include "Projection\ComponentMiccgZeroSolver.hpp"
+#include "Projection\DeflatedMiccgZeroSolver.hpp"
+#include "Projection\FluidComponents.hpp"
 #include "Projection\GridAllignedPressureSolvePreparator.hpp"
+#include "Projection\MgpcgSolver.hpp"
+#include "Projection\MiccgZeroKernel.hpp"
 #include "Projection\MiccgZeroSolver.hpp"
+#include "Projection\MiccgZeroSolverBase.hpp"
+#include "Projection\MixedPrecisionMiccgZeroSolver.hpp"
+#include "Projection\MultigridPreconditioner.hpp"
+#include "Projection\PipelinedMiccgZeroSolver.hpp"
+#include "Projection\PressureStencilGrid.hpp"
+#include "Projection\RedBlackGaussSeidelSolver.hpp"
+#include "Projection\SimdRunOperations.hpp"
 #include "Projection\VelocityProjectionMovement.hpp"
\ No newline at end of file
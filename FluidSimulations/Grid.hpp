@@ -1,40 +1,72 @@
 #pragma once
 
+#include "AlignedArray.hpp"
+#include "GridHalo.hpp"
+#include "GridLayouts.hpp"
 #include "ScalarVectorDefinitions.hpp"
 
+#include <cassert>
 #include <memory>
 
 namespace FluidSimulations
 {
 
-template <typename ValueType>
+template <typename ValueType, typename LayoutType = DefaultGridLayout>
 class Grid
 {
 public:
+    template <typename OtherValueType>
+    using Rebind = Grid<OtherValueType, LayoutType>;
+
     Grid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes)
+        : Grid(iRes, jRes, kRes, GridHalo(0))
+    {
+    }
+
+    Grid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes, 
+        const ValueType& defaultValue)
+        : Grid(iRes, jRes, kRes, GridHalo(0), defaultValue)
+    {
+    }
+
+    Grid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const GridHalo& halo)
         : m_iRes(iRes)
         , m_jRes(jRes)
         , m_kRes(kRes)
-        , m_iMul(jRes * kRes)
-        , m_jMul(kRes)
-        , m_data(new ValueType[iRes * jRes * kRes])
+        , m_halo(halo.width())
+        , m_layout(iRes + 2 * m_halo, jRes + 2 * m_halo, kRes + 2 * m_halo)
+        , m_data(m_layout.size())
     {
     }
 
-
-    Grid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes, 
-        const ValueType& defaultValue)
+    Grid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const GridHalo& halo, const std::shared_ptr<char>& memory)
         : m_iRes(iRes)
         , m_jRes(jRes)
         , m_kRes(kRes)
-        , m_iMul(jRes * kRes)
-        , m_jMul(kRes)
-        , m_data(new ValueType[iRes * jRes * kRes])
+        , m_halo(halo.width())
+        , m_layout(iRes + 2 * m_halo, jRes + 2 * m_halo, kRes + 2 * m_halo)
+        , m_data(m_layout.size(), memory)
+    {
+    }
+
+    Grid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const GridHalo& halo, const ValueType& defaultValue)
+        : Grid(iRes, jRes, kRes, halo)
     {
-        for (ValueType* dataPtr = m_data.get(); dataPtr != m_data.get() + iRes * jRes * kRes;
+        for (ValueType* dataPtr = m_data.data(); dataPtr != m_data.data() + storageSize();
             *(dataPtr++) = defaultValue);
     }
 
+    static inline std::size_t requiredMemory(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const GridHalo& halo)
+    {
+        const LayoutType layout(iRes + 2 * halo.width(), jRes + 2 * halo.width(), kRes + 2 * halo.width());
+
+        return AlignedArray<ValueType>::requiredMemory(layout.size());
+    }
+
     Grid(const Grid&) = delete;
     Grid& operator=(const Grid&) = delete;
 
@@ -58,25 +90,64 @@ public:
         return IntegersThreeDVector(iRes(), jRes(), kRes());
     }
 
+    inline const IntegerType& halo() const
+    {
+        return m_halo;
+    }
+
+    inline const LayoutType& layout() const
+    {
+        return m_layout;
+    }
+
+    inline IntegerType storageSize() const
+    {
+        return m_layout.size();
+    }
+
+    inline ValueType* data()
+    {
+        return m_data.data();
+    }
+
+    inline const ValueType* data() const
+    {
+        return m_data.data();
+    }
+
+    // Exchanges the values with a grid of the same resolution and halo without copying,
+    // everyone holding either grid sees the exchanged values. Both grids share the layout
+    // type, so equal resolutions and halos give equal layouts.
+
+    inline void swap(Grid& other)
+    {
+        assert(m_iRes == other.m_iRes && m_jRes == other.m_jRes && m_kRes == other.m_kRes);
+        assert(m_halo == other.m_halo);
+
+        m_data.swap(other.m_data);
+    }
+
     inline ValueType& at(const IntegerType i, const IntegerType j, const IntegerType k)
     {
-        return m_data[i * m_iMul + j * m_jMul + k];
+        return m_data[m_layout.index(i + m_halo, j + m_halo, k + m_halo)];
     }
 
     inline const ValueType& at(const IntegerType i, const IntegerType j, const IntegerType k) const
     {
-        return const_cast<const ValueType&>(const_cast<Grid<ValueType>&>(*this).at(i, j, k));
+        return const_cast<const ValueType&>(const_cast<Grid&>(*this).at(i, j, k));
     }
 
 private:
     const IntegerType m_iRes;
     const IntegerType m_jRes;
     const IntegerType m_kRes;
+    const IntegerType m_halo;
 
-    const IntegerType m_iMul;
-    const IntegerType m_jMul;
+    const LayoutType m_layout;
 
-    const std::unique_ptr<ValueType[]> m_data;
+    AlignedArray<ValueType> m_data;
 };
 
-}
\ No newline at end of file
+}
+
+#include "BitPackedGrid.hpp"
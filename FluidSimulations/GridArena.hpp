@@ -0,0 +1,134 @@
+#pragma once
+
+#include "GridDefinitions.hpp"
+
+#include <cstddef>
+#include <map>
+#include <memory>
+
+namespace FluidSimulations
+{
+
+// Pool of memory blocks for scratch grids. A checked out grid returns its block to the
+// arena when the last reference to it is gone, the next check out reuses the smallest
+// free block which is large enough, whatever value type the previous grid had, so the
+// values of a checked out grid are not initialized. Sparse grids allocate their leaves
+// on demand, so they are created directly. The pool is not synchronized, grids have to
+// be checked out and released on the main thread only.
+
+class GridArena
+{
+public:
+    GridArena()
+        : m_pool(std::make_shared<Pool>())
+    {}
+
+    GridArena(const GridArena&) = delete;
+    GridArena& operator=(const GridArena&) = delete;
+
+    template <typename GridType>
+    inline std::shared_ptr<GridType> checkOut(const IntegersThreeDVector& res)
+    {
+        return checkOut<GridType>(res, GridHalo(0));
+    }
+
+    template <typename GridType>
+    inline std::shared_ptr<GridType> checkOut(const IntegersThreeDVector& res, const GridHalo& halo)
+    {
+        return create(static_cast<GridType*>(nullptr), res, halo);
+    }
+
+    // Checks out a grid with the resolution and the halo of the given one, so the two can
+    // be swapped.
+
+    template <typename GridType>
+    inline std::shared_ptr<GridType> checkOutLike(const GridType& grid)
+    {
+        return checkOut<GridType>(grid.res(), haloOf(grid));
+    }
+
+private:
+    struct Pool
+    {
+        std::multimap<std::size_t, std::unique_ptr<char[]>> freeBlocks;
+    };
+
+    class BlockReturner
+    {
+    public:
+        BlockReturner(const std::weak_ptr<Pool>& pool, const std::size_t size)
+            : m_pool(pool)
+            , m_size(size)
+        {}
+
+        void operator()(char* memory) const
+        {
+            const std::shared_ptr<Pool> pool = m_pool.lock();
+
+            if (pool)
+            {
+                pool->freeBlocks.insert(std::make_pair(m_size, std::unique_ptr<char[]>(memory)));
+            }
+            else
+            {
+                delete[] memory;
+            }
+        }
+
+    private:
+        const std::weak_ptr<Pool> m_pool;
+        const std::size_t m_size;
+    };
+
+    std::shared_ptr<char> acquire(const std::size_t size)
+    {
+        const auto freeBlock = m_pool->freeBlocks.lower_bound(size);
+
+        if (freeBlock != m_pool->freeBlocks.end())
+        {
+            const std::size_t blockSize = freeBlock->first;
+            char* const memory = freeBlock->second.release();
+
+            m_pool->freeBlocks.erase(freeBlock);
+
+            return std::shared_ptr<char>(memory, BlockReturner(m_pool, blockSize));
+        }
+
+        return std::shared_ptr<char>(new char[size], BlockReturner(m_pool, size));
+    }
+
+    template <typename ValueType, typename LayoutType>
+    std::shared_ptr<Grid<ValueType, LayoutType>> create(Grid<ValueType, LayoutType>*,
+        const IntegersThreeDVector& res, const GridHalo& halo)
+    {
+        const std::size_t size = Grid<ValueType, LayoutType>::requiredMemory(res.x, res.y, res.z, halo);
+
+        return std::make_shared<Grid<ValueType, LayoutType>>(res.x, res.y, res.z, halo, acquire(size));
+    }
+
+    template <typename ValueType, typename LayoutType>
+    static inline GridHalo haloOf(const Grid<ValueType, LayoutType>& grid)
+    {
+        return GridHalo(grid.halo());
+    }
+
+    template <typename ValueType>
+    static inline GridHalo haloOf(const SparseGrid<ValueType>&)
+    {
+        return GridHalo(0);
+    }
+
+    template <typename ValueType>
+    std::shared_ptr<SparseGrid<ValueType>> create(SparseGrid<ValueType>*,
+        const IntegersThreeDVector& res, const GridHalo& halo)
+    {
+        return std::make_shared<SparseGrid<ValueType>>(res.x, res.y, res.z, halo);
+    }
+
+private:
+    const std::shared_ptr<Pool> m_pool;
+};
+
+typedef std::shared_ptr<GridArena> GridArenaPtr;
+
+}
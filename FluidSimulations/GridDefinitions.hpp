@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Grid.hpp"
+#include "SparseGrid.hpp"
 #include "ScalarVectorDefinitions.hpp"
 
 #include <memory>
@@ -20,6 +21,10 @@ typedef Grid<FloatsFourDVector> FloatsFourDVectorGrid;
 typedef std::shared_ptr<FloatsFourDVectorGrid> FloatsFourDVectorGridPtr;
 typedef std::shared_ptr<const FloatsFourDVectorGrid> FloatsFourDVectorGridConstPtr;
 
+typedef SparseGrid<FloatType> SparseFloatsGrid;
+typedef std::shared_ptr<SparseFloatsGrid> SparseFloatsGridPtr;
+typedef std::shared_ptr<const SparseFloatsGrid> SparseFloatsGridConstPtr;
+
 typedef Grid<bool> PredicateGrid;
 typedef std::shared_ptr<PredicateGrid> PredicateGridPtr;
 typedef std::shared_ptr<const PredicateGrid> PredicateGridConstPtr;
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "ScalarTypes.hpp"
+
+namespace FluidSimulations
+{
+
+// Width of the ghost cells layer stored around a grid, ghost cells are addressed
+// by indices in [-width, 0) and [res, res + width).
+
+class GridHalo
+{
+public:
+    explicit GridHalo(const IntegerType width)
+        : m_width(width)
+    {}
+
+    inline const IntegerType& width() const
+    {
+        return m_width;
+    }
+
+private:
+    const IntegerType m_width;
+};
+
+}
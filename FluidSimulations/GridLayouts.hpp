@@ -0,0 +1,105 @@
+#pragma once
+
+#include "ScalarVectorDefinitions.hpp"
+
+namespace FluidSimulations
+{
+
+class LinearGridLayout
+{
+public:
+    LinearGridLayout(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes)
+        : m_iRes(iRes)
+        , m_jRes(jRes)
+        , m_kRes(kRes)
+        , m_iMul(jRes * kRes)
+        , m_jMul(kRes)
+    {
+    }
+
+    inline IntegerType size() const
+    {
+        return m_iRes * m_jRes * m_kRes;
+    }
+
+    inline IntegersThreeDVector tileRes() const
+    {
+        return IntegersThreeDVector(m_iRes, m_jRes, m_kRes);
+    }
+
+    inline IntegerType index(const IntegerType i, const IntegerType j, const IntegerType k) const
+    {
+        return i * m_iMul + j * m_jMul + k;
+    }
+
+private:
+    const IntegerType m_iRes;
+    const IntegerType m_jRes;
+    const IntegerType m_kRes;
+
+    const IntegerType m_iMul;
+    const IntegerType m_jMul;
+};
+
+// Cells are stored in 8x8x8 bricks, bricks follow each other in row-major order
+// and cells inside of a brick follow the Morton (Z) curve.
+
+class BrickedGridLayout
+{
+public:
+    static const IntegerType brickBits = 3;
+    static const IntegerType brickSize = 1 << brickBits;
+    static const IntegerType brickVolume = brickSize * brickSize * brickSize;
+
+    BrickedGridLayout(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes)
+        : m_iBricks(bricksCount(iRes))
+        , m_jBricks(bricksCount(jRes))
+        , m_kBricks(bricksCount(kRes))
+    {
+    }
+
+    inline IntegerType size() const
+    {
+        return m_iBricks * m_jBricks * m_kBricks * brickVolume;
+    }
+
+    inline IntegersThreeDVector tileRes() const
+    {
+        return IntegersThreeDVector(brickSize, brickSize, brickSize);
+    }
+
+    inline IntegerType index(const IntegerType i, const IntegerType j, const IntegerType k) const
+    {
+        const IntegerType brick = ((i >> brickBits) * m_jBricks + (j >> brickBits)) * m_kBricks + (k >> brickBits);
+
+        const IntegerType cell = (spreadBits(i & (brickSize - 1)) << 2)
+            | (spreadBits(j & (brickSize - 1)) << 1)
+            | spreadBits(k & (brickSize - 1));
+
+        return brick * brickVolume + cell;
+    }
+
+private:
+    static inline IntegerType bricksCount(const IntegerType res)
+    {
+        return (res + brickSize - 1) >> brickBits;
+    }
+
+    static inline IntegerType spreadBits(const IntegerType value)
+    {
+        return (value & 1) | ((value & 2) << 2) | ((value & 4) << 4);
+    }
+
+private:
+    const IntegerType m_iBricks;
+    const IntegerType m_jBricks;
+    const IntegerType m_kBricks;
+};
+
+#ifdef FLUID_SIMULATIONS_BRICKED_GRIDS
+typedef BrickedGridLayout DefaultGridLayout;
+#else
+typedef LinearGridLayout DefaultGridLayout;
+#endif
+
+}
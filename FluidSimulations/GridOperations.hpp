@@ -2,37 +2,286 @@
 
 #include "GridDefinitions.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 namespace FluidSimulations
 {
 
-template <typename ValueType>
-inline void setValues(const std::shared_ptr<Grid<ValueType>>& target, const ValueType& value)
+template <typename ValueType, typename LayoutType, typename FunctorType>
+inline void forEachTileOrdered(const Grid<ValueType, LayoutType>& grid,
+    const bool iAscending, const bool jAscending, const bool kAscending, FunctorType functor)
 {
-    for (IntegerType i = 0; i < target->iRes(); ++i)
+    const IntegersThreeDVector tileRes = grid.layout().tileRes();
+    const IntegerType halo = grid.halo();
+
+    const IntegerType iTiles = (grid.iRes() + halo + tileRes.x - 1) / tileRes.x;
+    const IntegerType jTiles = (grid.jRes() + halo + tileRes.y - 1) / tileRes.y;
+    const IntegerType kTiles = (grid.kRes() + halo + tileRes.z - 1) / tileRes.z;
+
+    for (IntegerType iTile = 0; iTile < iTiles; ++iTile)
     {
-        for (IntegerType j = 0; j < target->jRes(); ++j)
+        const IntegerType iBegin = (iAscending ? iTile : iTiles - 1 - iTile) * tileRes.x - halo;
+
+        for (IntegerType jTile = 0; jTile < jTiles; ++jTile)
         {
-            for (IntegerType k = 0; k < target->kRes(); ++k)
+            const IntegerType jBegin = (jAscending ? jTile : jTiles - 1 - jTile) * tileRes.y - halo;
+
+            for (IntegerType kTile = 0; kTile < kTiles; ++kTile)
             {
-                target->at(i, j, k) = value;
+                const IntegerType kBegin = (kAscending ? kTile : kTiles - 1 - kTile) * tileRes.z - halo;
+
+                functor(
+                    IntegersThreeDVector(std::max(iBegin, 0), std::max(jBegin, 0), std::max(kBegin, 0)),
+                    IntegersThreeDVector(
+                        std::min(iBegin + tileRes.x, grid.iRes()),
+                        std::min(jBegin + tileRes.y, grid.jRes()),
+                        std::min(kBegin + tileRes.z, grid.kRes())));
             }
         }
     }
 }
 
+template <typename ValueType, typename LayoutType, typename FunctorType>
+inline void forEachTile(const Grid<ValueType, LayoutType>& grid, FunctorType functor)
+{
+    forEachTileOrdered(grid, true, true, true, functor);
+}
+
+template <typename ValueType, typename FunctorType>
+inline void forEachTileOrdered(const SparseGrid<ValueType>& grid,
+    const bool iAscending, const bool jAscending, const bool kAscending, FunctorType functor)
+{
+    std::vector<IntegersThreeDVector> origins = grid.leafOrigins();
+
+    std::sort(origins.begin(), origins.end(),
+        [iAscending, jAscending, kAscending](const IntegersThreeDVector& left, const IntegersThreeDVector& right) -> bool
+    {
+        if (left.x != right.x)
+        {
+            return iAscending == (left.x < right.x);
+        }
+
+        if (left.y != right.y)
+        {
+            return jAscending == (left.y < right.y);
+        }
+
+        return left.z != right.z && kAscending == (left.z < right.z);
+    });
+
+    const IntegerType leafSize = SparseGrid<ValueType>::leafSize;
+
+    for (const IntegersThreeDVector& origin : origins)
+    {
+        functor(origin, IntegersThreeDVector(
+            std::min(origin.x + leafSize, grid.iRes()),
+            std::min(origin.y + leafSize, grid.jRes()),
+            std::min(origin.z + leafSize, grid.kRes())));
+    }
+}
+
+template <typename ValueType, typename FunctorType>
+inline void forEachTile(const SparseGrid<ValueType>& grid, FunctorType functor)
+{
+    forEachTileOrdered(grid, true, true, true, functor);
+}
+
+template <typename GridType, typename FunctorType>
+inline void forEachIndex(const GridType& grid, FunctorType functor)
+{
+    forEachTile(grid, [&functor](const IntegersThreeDVector& begin, const IntegersThreeDVector& end) -> void
+    {
+        for (IntegerType i = begin.x; i < end.x; ++i)
+        {
+            for (IntegerType j = begin.y; j < end.y; ++j)
+            {
+                for (IntegerType k = begin.z; k < end.z; ++k)
+                {
+                    functor(i, j, k);
+                }
+            }
+        }
+    });
+}
+
+template <typename GridType, typename FunctorType>
+inline void forEachIndexOrdered(const GridType& grid,
+    const bool iAscending, const bool jAscending, const bool kAscending, FunctorType functor)
+{
+    forEachTileOrdered(grid, iAscending, jAscending, kAscending,
+        [&functor, iAscending, jAscending, kAscending](const IntegersThreeDVector& begin, const IntegersThreeDVector& end) -> void
+    {
+        for (IntegerType iStep = 0; iStep < end.x - begin.x; ++iStep)
+        {
+            const IntegerType i = iAscending ? begin.x + iStep : end.x - 1 - iStep;
+
+            for (IntegerType jStep = 0; jStep < end.y - begin.y; ++jStep)
+            {
+                const IntegerType j = jAscending ? begin.y + jStep : end.y - 1 - jStep;
+
+                for (IntegerType kStep = 0; kStep < end.z - begin.z; ++kStep)
+                {
+                    const IntegerType k = kAscending ? begin.z + kStep : end.z - 1 - kStep;
+
+                    functor(i, j, k);
+                }
+            }
+        }
+    });
+}
+
+template <typename GridType, typename FunctorType>
+inline void forEachIndexReversed(const GridType& grid, FunctorType functor)
+{
+    forEachIndexOrdered(grid, false, false, false, functor);
+}
+
+template <typename ValueType, typename LayoutType>
+inline void setValues(const std::shared_ptr<Grid<ValueType, LayoutType>>& target, const ValueType& value)
+{
+    std::fill(target->data(), target->data() + target->storageSize(), value);
+}
+
+template <typename LayoutType>
+inline void setValues(const std::shared_ptr<Grid<bool, LayoutType>>& target, const bool& value)
+{
+    target->fill(value);
+}
+
+template <typename ValueType>
+inline void setValues(const std::shared_ptr<SparseGrid<ValueType>>& target, const ValueType& value)
+{
+    target->fill(value);
+}
+
+template <typename ValueType, typename LayoutType>
+inline void copyIn(const Grid<ValueType, LayoutType>& source, Grid<ValueType, LayoutType>& target)
+{
+    std::copy(source.data(), source.data() + source.storageSize(), target.data());
+}
+
+template <typename LayoutType>
+inline void copyIn(const Grid<bool, LayoutType>& source, Grid<bool, LayoutType>& target)
+{
+    std::copy(source.words(), source.words() + source.wordsCount(), target.words());
+}
+
 template <typename ValueType>
-inline void copyIn(const std::shared_ptr<const Grid<ValueType>>& source, const std::shared_ptr<Grid<ValueType>>& target)
+inline void copyIn(const SparseGrid<ValueType>& source, SparseGrid<ValueType>& target)
+{
+    target.copyIn(source);
+}
+
+template <typename ValueType, template <typename...> class GridType, typename... ParametersTypes>
+inline void copyIn(const std::shared_ptr<const GridType<ValueType, ParametersTypes...>>& source,
+    const std::shared_ptr<GridType<ValueType, ParametersTypes...>>& target)
+{
+    copyIn(*source, *target);
+}
+
+template <typename ValueType, template <typename...> class GridType, typename... ParametersTypes>
+inline void copyIn(const std::shared_ptr<GridType<ValueType, ParametersTypes...>>& source,
+    const std::shared_ptr<GridType<ValueType, ParametersTypes...>>& target)
+{
+    copyIn(*source, *target);
+}
+
+template <typename ValueType>
+class ConstantHaloPolicy
+{
+public:
+    ConstantHaloPolicy(const ValueType& value)
+        : m_value(value)
+    {}
+
+    template <typename GridType>
+    inline const ValueType& at(const GridType&, const IntegerType, const IntegerType, const IntegerType) const
+    {
+        return m_value;
+    }
+
+private:
+    const ValueType m_value;
+};
+
+class ClampHaloPolicy
 {
-    for (IntegerType i = 0; i < target->iRes(); ++i)
+public:
+    template <typename ValueType, typename LayoutType>
+    inline ValueType at(const Grid<ValueType, LayoutType>& grid, const IntegerType i, const IntegerType j, const IntegerType k) const
     {
-        for (IntegerType j = 0; j < target->jRes(); ++j)
+        return grid.at(
+            std::max(std::min(i, grid.iRes() - 1), 0),
+            std::max(std::min(j, grid.jRes() - 1), 0),
+            std::max(std::min(k, grid.kRes() - 1), 0));
+    }
+};
+
+template <typename ValueType, typename LayoutType, typename HaloPolicyType>
+inline void fillHalo(Grid<ValueType, LayoutType>& grid, const HaloPolicyType& policy)
+{
+    const IntegerType halo = grid.halo();
+
+    for (IntegerType i = -halo; i < grid.iRes() + halo; ++i)
+    {
+        for (IntegerType j = -halo; j < grid.jRes() + halo; ++j)
         {
-            for (IntegerType k = 0; k < target->kRes(); ++k)
+            const bool interiorRow = i >= 0 && i < grid.iRes() && j >= 0 && j < grid.jRes();
+
+            for (IntegerType k = -halo; k < grid.kRes() + halo; ++k)
             {
-                target->at(i, j, k) = source->at(i, j, k);
+                if (interiorRow && k >= 0 && k < grid.kRes())
+                {
+                    k = grid.kRes() - 1;
+                    continue;
+                }
+
+                grid.at(i, j, k) = policy.at(grid, i, j, k);
             }
         }
     }
 }
 
-}
\ No newline at end of file
+template <typename GridType>
+inline std::uint32_t stencilMask(const GridType& grid, const IntegerType i, const IntegerType j, const IntegerType k)
+{
+    return (grid.at(i, j, k) ? stencilCenterBit : 0)
+        | (grid.at(i - 1, j, k) ? stencilIMinusBit : 0)
+        | (grid.at(i + 1, j, k) ? stencilIPlusBit : 0)
+        | (grid.at(i, j - 1, k) ? stencilJMinusBit : 0)
+        | (grid.at(i, j + 1, k) ? stencilJPlusBit : 0)
+        | (grid.at(i, j, k - 1) ? stencilKMinusBit : 0)
+        | (grid.at(i, j, k + 1) ? stencilKPlusBit : 0);
+}
+
+template <typename LayoutType>
+inline std::uint32_t stencilMask(const Grid<bool, LayoutType>& grid, const IntegerType i, const IntegerType j, const IntegerType k)
+{
+    return grid.stencilMask(i, j, k);
+}
+
+template <typename SourceValueType, typename TargetValueType, typename LayoutType>
+inline void copyTopology(const Grid<SourceValueType, LayoutType>&, Grid<TargetValueType, LayoutType>&)
+{
+}
+
+template <typename SourceValueType, typename TargetValueType>
+inline void copyTopology(const SparseGrid<SourceValueType>& source, SparseGrid<TargetValueType>& target)
+{
+    target.copyTopology(source);
+}
+
+template <typename ValueType, typename LayoutType>
+inline void dilateTopology(Grid<ValueType, LayoutType>&)
+{
+}
+
+template <typename ValueType>
+inline void dilateTopology(SparseGrid<ValueType>& grid)
+{
+    grid.dilate();
+}
+
+}
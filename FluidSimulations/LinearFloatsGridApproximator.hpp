@@ -3,14 +3,16 @@
 #include "GridDefinitions.hpp"
 
 #include <algorithm>
+#include <cmath>
 
 namespace FluidSimulations
 {
 
-class LinearFloatsGridApproximator
+template <typename FloatsGridType>
+class LinearGridApproximator
 {
 public:
-    LinearFloatsGridApproximator(const FloatsGridConstPtr& approximated)
+    LinearGridApproximator(const std::shared_ptr<const FloatsGridType>& approximated)
         : m_approximated(approximated)
     {}
 
@@ -20,9 +22,9 @@ public:
         const IntegerType maxJ = m_approximated->jRes() - 2;
         const IntegerType maxK = m_approximated->kRes() - 2;
 
-        const IntegerType fX = std::max(std::min(static_cast<IntegerType>(floor(x)), maxI), 0);
-        const IntegerType fY = std::max(std::min(static_cast<IntegerType>(floor(y)), maxJ), 0);
-        const IntegerType fZ = std::max(std::min(static_cast<IntegerType>(floor(z)), maxK), 0);
+        const IntegerType fX = std::max(std::min(static_cast<IntegerType>(std::floor(x)), maxI), 0);
+        const IntegerType fY = std::max(std::min(static_cast<IntegerType>(std::floor(y)), maxJ), 0);
+        const IntegerType fZ = std::max(std::min(static_cast<IntegerType>(std::floor(z)), maxK), 0);
 
         const FloatType& v000 = m_approximated->at(fX, fY, fZ);
         const FloatType& v001 = m_approximated->at(fX, fY, fZ + 1);
@@ -54,7 +56,10 @@ public:
     }
 
 private:
-    const FloatsGridConstPtr m_approximated;
+    const std::shared_ptr<const FloatsGridType> m_approximated;
 };
 
+typedef LinearGridApproximator<FloatsGrid> LinearFloatsGridApproximator;
+typedef LinearGridApproximator<SparseFloatsGrid> LinearSparseFloatsGridApproximator;
+
 }
@@ -1,8 +1,9 @@
 #pragma once
 
-#include "GridDefinitions.hpp"
+#include "MacVelocityGrid.hpp"
 
 #include <algorithm>
+#include <cmath>
 
 namespace FluidSimulations
 {
@@ -18,7 +19,7 @@ class LinearObjectVelocityGridApproximator
 {
 public:
     LinearObjectVelocityGridApproximator(
-        const FloatsThreeDVectorGridConstPtr& staggeredVelocity,
+        const MacVelocityGridConstPtr& staggeredVelocity,
         const PredicateSpaceType& interiorPredicate, 
         const NearestSurfacePointCalculatorType& nearestObjectSurfacePoint)
         : m_staggeredVelocity(staggeredVelocity)
@@ -64,27 +65,21 @@ private:
         kComponent
     };
 
-    FloatType at(const IntegerType i, const IntegerType j, const IntegerType k, const Component component) const
+    const FloatsGrid& componentGrid(const Component component) const
     {
-        const FloatsThreeDVector& velocity = m_staggeredVelocity->at(i, j, k);
-
         switch (component)
         {
         case iComponent:
         {
-            return velocity.x;
+            return m_staggeredVelocity->iComponent();
         }
         case jComponent:
         {
-            return velocity.y;
-        }
-        case kComponent:
-        {
-            return velocity.z;
+            return m_staggeredVelocity->jComponent();
         }
         default:
         {
-            return 0;
+            return m_staggeredVelocity->kComponent();
         }
         }
     }
@@ -95,26 +90,28 @@ private:
         const FloatType uY = component == jComponent ? (y + 0.5f) : y;
         const FloatType uZ = component == kComponent ? (z + 0.5f) : z;
 
-        const IntegerType maxI = m_staggeredVelocity->iRes() - 2;
-        const IntegerType maxJ = m_staggeredVelocity->jRes() - 2;
-        const IntegerType maxK = m_staggeredVelocity->kRes() - 2;
+        const FloatsGrid& velocity = componentGrid(component);
+
+        const IntegerType maxI = velocity.iRes() - 2;
+        const IntegerType maxJ = velocity.jRes() - 2;
+        const IntegerType maxK = velocity.kRes() - 2;
 
-        const IntegerType fX = std::max(std::min(static_cast<IntegerType>(floor(uX)), maxI), 0);
-        const IntegerType fY = std::max(std::min(static_cast<IntegerType>(floor(uY)), maxJ), 0);
-        const IntegerType fZ = std::max(std::min(static_cast<IntegerType>(floor(uZ)), maxK), 0);
+        const IntegerType fX = std::max(std::min(static_cast<IntegerType>(std::floor(uX)), maxI), 0);
+        const IntegerType fY = std::max(std::min(static_cast<IntegerType>(std::floor(uY)), maxJ), 0);
+        const IntegerType fZ = std::max(std::min(static_cast<IntegerType>(std::floor(uZ)), maxK), 0);
 
         const FloatType rX = component == iComponent ? (fX - 0.5f) : fX;
         const FloatType rY = component == jComponent ? (fY - 0.5f) : fY;
         const FloatType rZ = component == kComponent ? (fZ - 0.5f) : fZ;
 
-        const FloatType v000 = at(fX, fY, fZ, component);
-        const FloatType v001 = at(fX, fY, fZ + 1, component);
-        const FloatType v010 = at(fX, fY + 1, fZ, component);
-        const FloatType v011 = at(fX, fY + 1, fZ + 1, component);
-        const FloatType v100 = at(fX + 1, fY, fZ, component);
-        const FloatType v101 = at(fX + 1, fY, fZ + 1, component);
-        const FloatType v110 = at(fX + 1, fY + 1, fZ, component);
-        const FloatType v111 = at(fX + 1, fY + 1, fZ + 1, component);
+        const FloatType v000 = velocity.at(fX, fY, fZ);
+        const FloatType v001 = velocity.at(fX, fY, fZ + 1);
+        const FloatType v010 = velocity.at(fX, fY + 1, fZ);
+        const FloatType v011 = velocity.at(fX, fY + 1, fZ + 1);
+        const FloatType v100 = velocity.at(fX + 1, fY, fZ);
+        const FloatType v101 = velocity.at(fX + 1, fY, fZ + 1);
+        const FloatType v110 = velocity.at(fX + 1, fY + 1, fZ);
+        const FloatType v111 = velocity.at(fX + 1, fY + 1, fZ + 1);
 
         const bool p000 = m_objectPredicate.at(rX, rY, rZ);
         const bool p001 = m_objectPredicate.at(rX, rY, rZ + 1);
@@ -183,7 +180,7 @@ private:
     }
 
 private:
-    const FloatsThreeDVectorGridConstPtr m_staggeredVelocity;
+    const MacVelocityGridConstPtr m_staggeredVelocity;
     const PredicateSpaceType m_objectPredicate;
     const NearestSurfacePointCalculatorType m_nearestObjectSurfacePoint;
 };
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "GridDefinitions.hpp"
+
+#include <memory>
+
+namespace FluidSimulations
+{
+
+class MacVelocityGrid
+{
+public:
+    MacVelocityGrid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const FloatType defaultValue = static_cast<FloatType>(0))
+        : m_iRes(iRes)
+        , m_jRes(jRes)
+        , m_kRes(kRes)
+        , m_iComponent(std::make_shared<FloatsGrid>(iRes + 1, jRes, kRes, defaultValue))
+        , m_jComponent(std::make_shared<FloatsGrid>(iRes, jRes + 1, kRes, defaultValue))
+        , m_kComponent(std::make_shared<FloatsGrid>(iRes, jRes, kRes + 1, defaultValue))
+    {
+    }
+
+    MacVelocityGrid(const MacVelocityGrid&) = delete;
+    MacVelocityGrid& operator=(const MacVelocityGrid&) = delete;
+
+    inline const IntegerType& iRes() const
+    {
+        return m_iRes;
+    }
+
+    inline const IntegerType& jRes() const
+    {
+        return m_jRes;
+    }
+
+    inline const IntegerType& kRes() const
+    {
+        return m_kRes;
+    }
+
+    inline IntegersThreeDVector res() const
+    {
+        return IntegersThreeDVector(iRes(), jRes(), kRes());
+    }
+
+    inline const FloatsGridPtr& iComponent()
+    {
+        return m_iComponent;
+    }
+
+    inline const FloatsGridPtr& jComponent()
+    {
+        return m_jComponent;
+    }
+
+    inline const FloatsGridPtr& kComponent()
+    {
+        return m_kComponent;
+    }
+
+    inline const FloatsGrid& iComponent() const
+    {
+        return *m_iComponent;
+    }
+
+    inline const FloatsGrid& jComponent() const
+    {
+        return *m_jComponent;
+    }
+
+    inline const FloatsGrid& kComponent() const
+    {
+        return *m_kComponent;
+    }
+
+private:
+    const IntegerType m_iRes;
+    const IntegerType m_jRes;
+    const IntegerType m_kRes;
+
+    const FloatsGridPtr m_iComponent;
+    const FloatsGridPtr m_jComponent;
+    const FloatsGridPtr m_kComponent;
+};
+
+typedef std::shared_ptr<MacVelocityGrid> MacVelocityGridPtr;
+typedef std::shared_ptr<const MacVelocityGrid> MacVelocityGridConstPtr;
+
+}
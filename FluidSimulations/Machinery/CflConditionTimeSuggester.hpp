@@ -1,6 +1,8 @@
 #pragma once
 
-#include "../GridDefinitions.hpp"
+#include "../GridOperations.hpp"
+#include "../MacVelocityGrid.hpp"
+#include "../ParallelGridOperations.hpp"
 #include "../ScalarVectorOperations.hpp"
 #include "ITimeSuggester.hpp"
 
@@ -15,44 +17,58 @@ class CflConditionTimeSuggester
 {
 public:
     CflConditionTimeSuggester(
-        const FloatsThreeDVectorGridConstPtr& velocity,
+        const MacVelocityGridConstPtr& velocity,
         const FloatType maxAccelerationRate)
+        : CflConditionTimeSuggester(velocity, maxAccelerationRate, std::make_shared<TaskScheduler>(1))
+    {}
+
+    CflConditionTimeSuggester(
+        const MacVelocityGridConstPtr& velocity,
+        const FloatType maxAccelerationRate,
+        const TaskSchedulerPtr& scheduler)
         : m_velocity(velocity)
         , m_maxAccelerationRate(maxAccelerationRate)
+        , m_scheduler(scheduler)
     {}
 
     virtual FloatType suggest() const override
     {
-        return 5 / (maxSpeed() + sqrt(5 * m_maxAccelerationRate));
+        return 5 / (maxSpeed() + std::sqrt(5 * m_maxAccelerationRate));
     }
 
 private:
     FloatType maxSpeed() const
     {
-        FloatType maxSpeed = 0;
+        const FloatsThreeDVector maxComponents(
+            maxAbsValue(m_velocity->iComponent()),
+            maxAbsValue(m_velocity->jComponent()),
+            maxAbsValue(m_velocity->kComponent()));
+
+        return norm(maxComponents);
+    }
 
-        for (IntegerType i = 0; i != m_velocity->iRes(); ++i)
+    FloatType maxAbsValue(const FloatsGrid& component) const
+    {
+        return parallelReduceIndex(*m_scheduler, component, static_cast<FloatType>(0),
+            [&component](FloatType& maxValue, const IntegerType i, const IntegerType j, const IntegerType k) -> void
         {
-            for (IntegerType j = 0; j != m_velocity->jRes(); ++j)
+            const FloatType currentValue = std::abs(component.at(i, j, k));
+
+            if (currentValue > maxValue)
             {
-                for (IntegerType k = 0; k != m_velocity->kRes(); ++k)
-                {
-                    const FloatType currentSpeed = norm(m_velocity->at(i, j, k));
-
-                    if (currentSpeed > maxSpeed)
-                    {
-                        maxSpeed = currentSpeed;
-                    }
-                }
+                maxValue = currentValue;
             }
-        }
-
-        return maxSpeed;
+        },
+            [](const FloatType left, const FloatType right) -> FloatType
+        {
+            return right > left ? right : left;
+        });
     }
 
 private:
-    const FloatsThreeDVectorGridConstPtr m_velocity;
+    const MacVelocityGridConstPtr m_velocity;
     const FloatType m_maxAccelerationRate;
+    const TaskSchedulerPtr m_scheduler;
 };
 
 typedef std::shared_ptr<const ITimeSuggester> ITimeSuggesterConstPtr;
@@ -2,7 +2,9 @@
 
 #include "../IMovement.hpp"
 #include "../ISimulator.hpp"
+#include "../TaskScheduler.hpp"
 #include "ITimeSuggester.hpp"
+#include "StepTimeBudget.hpp"
 
 #include <vector>
 #include <algorithm>
@@ -21,18 +23,59 @@ public:
         const ITimeSuggesterConstPtr timeSuggester,
         const std::vector<IMovementPtr>& movements,
         const FloatType timeInterval)
+        : ConstantTimeSimulator(timeSuggester, movements, timeInterval, std::make_shared<TaskScheduler>(1))
+    {}
+
+    ConstantTimeSimulator(
+        const ITimeSuggesterConstPtr timeSuggester,
+        const std::vector<IMovementPtr>& movements,
+        const FloatType timeInterval,
+        const TaskSchedulerPtr& scheduler)
+        : ConstantTimeSimulator(timeSuggester, movements, timeInterval, scheduler, StepTimeBudgetPtr())
+    {}
+
+    // With a budget every step starts it and gives each of its intervals a share of it.
+
+    ConstantTimeSimulator(
+        const ITimeSuggesterConstPtr timeSuggester,
+        const std::vector<IMovementPtr>& movements,
+        const FloatType timeInterval,
+        const TaskSchedulerPtr& scheduler,
+        const StepTimeBudgetPtr& budget)
         : m_timeSuggester(timeSuggester)
         , m_movements(movements)
         , m_timeInterval(timeInterval)
+        , m_scheduler(scheduler)
+        , m_budget(budget)
     {}
 
+    inline const TaskSchedulerPtr& scheduler() const
+    {
+        return m_scheduler;
+    }
+
+    inline const StepTimeBudgetPtr& budget() const
+    {
+        return m_budget;
+    }
+
     virtual void step() override
     {
+        if (m_budget)
+        {
+            m_budget->startStep();
+        }
+
         FloatType residualTimeInterval = m_timeInterval;
         while (residualTimeInterval > 0)
         {
             const FloatType nextTimeInterval = std::min(m_timeSuggester->suggest(), residualTimeInterval);
 
+            if (m_budget)
+            {
+                m_budget->startInterval(nextTimeInterval / residualTimeInterval);
+            }
+
             move(nextTimeInterval);
 
             residualTimeInterval -= nextTimeInterval;
@@ -53,6 +96,8 @@ private:
     const ITimeSuggesterConstPtr m_timeSuggester;
     const std::vector<IMovementPtr> m_movements;
     const FloatType m_timeInterval;
+    const TaskSchedulerPtr m_scheduler;
+    const StepTimeBudgetPtr m_budget;
 };
 
 }
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../ScalarTypes.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+namespace FluidSimulations
+{
+
+namespace Machinery
+{
+
+// Wall clock time of a simulation step, shared by the simulator which starts it and the
+// movements which fit their work into it. The simulator splits the time left among the
+// intervals of the step in proportion to their simulated time, a movement checks whether
+// the current interval has expired. The movements report the divergence they leave in the
+// velocity, the budget keeps the largest one of the step.
+
+class StepTimeBudget
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit StepTimeBudget(const double stepSeconds)
+        : m_stepDuration(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(stepSeconds)))
+        , m_stepDeadline(Clock::now())
+        , m_intervalDeadline(Clock::now())
+        , m_divergence(0)
+    {
+    }
+
+    StepTimeBudget(const StepTimeBudget&) = delete;
+    StepTimeBudget& operator=(const StepTimeBudget&) = delete;
+
+    void startStep()
+    {
+        m_stepDeadline = Clock::now() + m_stepDuration;
+        m_intervalDeadline = m_stepDeadline;
+        m_divergence = 0;
+    }
+
+    // Gives the interval the share of the time left in the step, the share is the part of
+    // the simulated time left in the step which the interval takes.
+
+    void startInterval(const FloatType share)
+    {
+        const Clock::time_point now = Clock::now();
+        const Clock::duration left = std::max(m_stepDeadline - now, Clock::duration::zero());
+
+        m_intervalDeadline = now + std::chrono::duration_cast<Clock::duration>(left * static_cast<double>(std::min<FloatType>(share, 1)));
+    }
+
+    inline bool expired() const
+    {
+        return Clock::now() >= m_intervalDeadline;
+    }
+
+    void reportDivergence(const FloatType divergence)
+    {
+        m_divergence = std::max(m_divergence, divergence);
+    }
+
+    // The largest divergence reported since the start of the step.
+
+    inline FloatType divergence() const
+    {
+        return m_divergence;
+    }
+
+private:
+    const Clock::duration m_stepDuration;
+
+    Clock::time_point m_stepDeadline;
+    Clock::time_point m_intervalDeadline;
+
+    FloatType m_divergence;
+};
+
+typedef std::shared_ptr<StepTimeBudget> StepTimeBudgetPtr;
+
+}
+
+}
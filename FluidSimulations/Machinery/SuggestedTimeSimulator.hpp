@@ -2,6 +2,7 @@
 
 #include "../IMovement.hpp"
 #include "../ISimulator.hpp"
+#include "../TaskScheduler.hpp"
 #include "ITimeSuggester.hpp"
 
 #include <vector>
@@ -20,10 +21,23 @@ public:
     SuggestedTimeSimulator(
         const ITimeSuggesterConstPtr timeSuggester, 
         const std::vector<IMovementPtr>& movements)
+        : SuggestedTimeSimulator(timeSuggester, movements, std::make_shared<TaskScheduler>(1))
+    {}
+
+    SuggestedTimeSimulator(
+        const ITimeSuggesterConstPtr timeSuggester,
+        const std::vector<IMovementPtr>& movements,
+        const TaskSchedulerPtr& scheduler)
         : m_timeSuggester(timeSuggester)
         , m_movements(movements)
+        , m_scheduler(scheduler)
     {}
 
+    inline const TaskSchedulerPtr& scheduler() const
+    {
+        return m_scheduler;
+    }
+
     virtual void step() override
     {
         const FloatType suggestedTime = m_timeSuggester->suggest();
@@ -38,6 +52,7 @@ public:
 private:
     const ITimeSuggesterConstPtr m_timeSuggester;
     const std::vector<IMovementPtr> m_movements;
+    const TaskSchedulerPtr m_scheduler;
 };
 
 }
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "GridOperations.hpp"
+#include "TaskScheduler.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace FluidSimulations
+{
+
+// Dense grids are split into slabs of constant i, sparse grids into their leaves.
+// The cells of a slab or a leaf are visited in the order of forEachIndex.
+
+template <typename ValueType, typename LayoutType, typename FunctorType>
+inline void parallelForEachIndex(TaskScheduler& scheduler, const Grid<ValueType, LayoutType>& grid, FunctorType functor)
+{
+    scheduler.parallelFor(0, grid.iRes(), 1, [&](const IntegerType iBegin, const IntegerType iEnd) -> void
+    {
+        for (IntegerType i = iBegin; i < iEnd; ++i)
+        {
+            for (IntegerType j = 0; j < grid.jRes(); ++j)
+            {
+                for (IntegerType k = 0; k < grid.kRes(); ++k)
+                {
+                    functor(i, j, k);
+                }
+            }
+        }
+    });
+}
+
+template <typename ValueType, typename FunctorType>
+inline void parallelForEachIndex(TaskScheduler& scheduler, const SparseGrid<ValueType>& grid, FunctorType functor)
+{
+    const std::vector<IntegersThreeDVector> origins = grid.leafOrigins();
+    const IntegerType leafSize = SparseGrid<ValueType>::leafSize;
+
+    scheduler.parallelFor(0, static_cast<IntegerType>(origins.size()), 1, [&](const IntegerType leafBegin, const IntegerType leafEnd) -> void
+    {
+        for (IntegerType leaf = leafBegin; leaf < leafEnd; ++leaf)
+        {
+            const IntegersThreeDVector& origin = origins[leaf];
+
+            for (IntegerType i = origin.x; i < std::min(origin.x + leafSize, grid.iRes()); ++i)
+            {
+                for (IntegerType j = origin.y; j < std::min(origin.y + leafSize, grid.jRes()); ++j)
+                {
+                    for (IntegerType k = origin.z; k < std::min(origin.z + leafSize, grid.kRes()); ++k)
+                    {
+                        functor(i, j, k);
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Visits the cells so that every cell comes after its i - 1, j - 1 and k - 1 neighbours,
+// or after its i + 1, j + 1 and k + 1 neighbours if not ascending, as a lexicographic
+// sweep does. The grid is split into blocks of whole columns along k, the blocks of
+// one diagonal bi + bj = const depend on the previous diagonal only and run in parallel.
+
+const IntegerType wavefrontBlockWidth = 8;
+
+template <typename ValueType, typename LayoutType, typename FunctorType>
+inline void parallelForEachIndexWavefront(TaskScheduler& scheduler, const Grid<ValueType, LayoutType>& grid,
+    const bool ascending, FunctorType functor)
+{
+    const IntegerType iBlocks = (grid.iRes() + wavefrontBlockWidth - 1) / wavefrontBlockWidth;
+    const IntegerType jBlocks = (grid.jRes() + wavefrontBlockWidth - 1) / wavefrontBlockWidth;
+
+    for (IntegerType diagonalStep = 0; diagonalStep < iBlocks + jBlocks - 1; ++diagonalStep)
+    {
+        const IntegerType diagonal = ascending ? diagonalStep : iBlocks + jBlocks - 2 - diagonalStep;
+
+        const IntegerType iBlockBegin = std::max<IntegerType>(diagonal - jBlocks + 1, 0);
+        const IntegerType iBlockEnd = std::min(diagonal + 1, iBlocks);
+
+        scheduler.parallelFor(iBlockBegin, iBlockEnd, 1, [&](const IntegerType blockBegin, const IntegerType blockEnd) -> void
+        {
+            for (IntegerType iBlock = blockBegin; iBlock < blockEnd; ++iBlock)
+            {
+                const IntegerType iBegin = iBlock * wavefrontBlockWidth;
+                const IntegerType jBegin = (diagonal - iBlock) * wavefrontBlockWidth;
+
+                const IntegerType iCount = std::min(wavefrontBlockWidth, grid.iRes() - iBegin);
+                const IntegerType jCount = std::min(wavefrontBlockWidth, grid.jRes() - jBegin);
+
+                for (IntegerType iStep = 0; iStep < iCount; ++iStep)
+                {
+                    const IntegerType i = ascending ? iBegin + iStep : iBegin + iCount - 1 - iStep;
+
+                    for (IntegerType jStep = 0; jStep < jCount; ++jStep)
+                    {
+                        const IntegerType j = ascending ? jBegin + jStep : jBegin + jCount - 1 - jStep;
+
+                        for (IntegerType kStep = 0; kStep < grid.kRes(); ++kStep)
+                        {
+                            functor(i, j, ascending ? kStep : grid.kRes() - 1 - kStep);
+                        }
+                    }
+                }
+            }
+        });
+    }
+}
+
+// Accumulates every slab from the identity with accumulate(result, i, j, k) and
+// combines the slab results in the order of the slabs.
+
+template <typename ResultType, typename ValueType, typename LayoutType, typename AccumulateType, typename CombineType>
+inline ResultType parallelReduceIndex(TaskScheduler& scheduler, const Grid<ValueType, LayoutType>& grid,
+    const ResultType& identity, AccumulateType accumulate, CombineType combine)
+{
+    return scheduler.parallelReduce(0, grid.iRes(), 1, identity,
+        [&](const IntegerType iBegin, const IntegerType iEnd) -> ResultType
+    {
+        ResultType result = identity;
+
+        for (IntegerType i = iBegin; i < iEnd; ++i)
+        {
+            for (IntegerType j = 0; j < grid.jRes(); ++j)
+            {
+                for (IntegerType k = 0; k < grid.kRes(); ++k)
+                {
+                    accumulate(result, i, j, k);
+                }
+            }
+        }
+
+        return result;
+    }, combine);
+}
+
+}
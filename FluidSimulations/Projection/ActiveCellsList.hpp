@@ -0,0 +1,210 @@
+#pragma once
+
+#include "../GridDefinitions.hpp"
+#include "../TaskScheduler.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// Storage indices of the cells of a predicate and of their six face neighbours, in the
+// storage order of the grids of the given resolution with a halo one cell wide. Grids of
+// any value type with that resolution and halo share the indices, so the loops over the
+// list do not depend on the size of the container.
+
+class ActiveCellsList
+{
+public:
+    enum Neighbour
+    {
+        iMinusNeighbour,
+        iPlusNeighbour,
+        jMinusNeighbour,
+        jPlusNeighbour,
+        kMinusNeighbour,
+        kPlusNeighbour,
+        neighboursCount
+    };
+
+    static const IntegerType haloWidth = 1;
+
+    template <typename PredicateSpaceType>
+    ActiveCellsList(TaskScheduler& scheduler, const IntegersThreeDVector& resolution, const PredicateSpaceType& predicate)
+        : m_layout(resolution.x + 2 * haloWidth, resolution.y + 2 * haloWidth, resolution.z + 2 * haloWidth)
+    {
+        std::vector<std::vector<Entry>> slabs(resolution.x);
+
+        scheduler.parallelFor(0, resolution.x, 1, [&](const IntegerType iBegin, const IntegerType iEnd) -> void
+        {
+            for (IntegerType i = iBegin; i < iEnd; ++i)
+            {
+                for (IntegerType j = 0; j < resolution.y; ++j)
+                {
+                    for (IntegerType k = 0; k < resolution.z; ++k)
+                    {
+                        if (predicate.at(i, j, k))
+                        {
+                            slabs[i].push_back(entry(i, j, k));
+                        }
+                    }
+                }
+            }
+        });
+
+        std::vector<Entry> entries;
+
+        for (const std::vector<Entry>& slab : slabs)
+        {
+            entries.insert(entries.end(), slab.begin(), slab.end());
+        }
+
+        const auto storageOrder = [](const Entry& left, const Entry& right) -> bool
+        {
+            return left.cell < right.cell;
+        };
+
+        if (!std::is_sorted(entries.begin(), entries.end(), storageOrder))
+        {
+            std::sort(entries.begin(), entries.end(), storageOrder);
+        }
+
+        m_cells.reserve(entries.size());
+        m_neighbours.reserve(entries.size() * neighboursCount);
+
+        for (std::size_t index = 0; index != entries.size(); ++index)
+        {
+            const Entry& current = entries[index];
+
+            if (index == 0 || !continues(entries[index - 1], current))
+            {
+                m_runStarts.push_back(static_cast<IntegerType>(index));
+            }
+
+            m_cells.push_back(current.cell);
+            m_neighbours.insert(m_neighbours.end(), current.neighbours, current.neighbours + neighboursCount);
+        }
+
+        m_runStarts.push_back(size());
+    }
+
+    ActiveCellsList(const ActiveCellsList&) = delete;
+    ActiveCellsList& operator=(const ActiveCellsList&) = delete;
+
+    // Whether the grid shares the indices of the lists of the resolution, the solvers check
+    // the grids they index with the lists of the pressure resolution.
+
+    template <typename GridType>
+    static inline bool sharesIndices(const GridType& grid, const IntegersThreeDVector& resolution)
+    {
+        return grid.iRes() == resolution.x && grid.jRes() == resolution.y && grid.kRes() == resolution.z
+            && grid.halo() == haloWidth;
+    }
+
+    inline IntegerType size() const
+    {
+        return static_cast<IntegerType>(m_cells.size());
+    }
+
+    inline IntegerType cell(const IntegerType index) const
+    {
+        return m_cells[index];
+    }
+
+    inline IntegerType neighbour(const IntegerType index, const Neighbour neighbour) const
+    {
+        return m_neighbours[index * neighboursCount + neighbour];
+    }
+
+    // Calls functor(index, count) for the parts of [begin, end) in which the cell and each of
+    // its neighbours follow the previous ones in storage, so that the loops over a part can
+    // load the values of the cells and of the neighbours of the same direction contiguously.
+
+    template <typename FunctorType>
+    inline void forEachRun(const IntegerType begin, const IntegerType end, FunctorType functor) const
+    {
+        auto run = std::upper_bound(m_runStarts.begin(), m_runStarts.end(), begin) - 1;
+
+        for (IntegerType index = begin; index < end; ++run)
+        {
+            const IntegerType runEnd = std::min(*(run + 1), end);
+
+            functor(index, runEnd - index);
+
+            index = runEnd;
+        }
+    }
+
+    // Calls functor(begin, end) for the chunks of the list.
+
+    template <typename FunctorType>
+    inline void parallelForChunks(TaskScheduler& scheduler, FunctorType functor) const
+    {
+        scheduler.parallelFor(0, size(), chunkSize, functor);
+    }
+
+    // Combines the results of map(begin, end) for the chunks of the list in their order.
+
+    template <typename ValueType, typename MapType, typename CombineType>
+    inline ValueType parallelReduceChunks(TaskScheduler& scheduler, const ValueType& identity, MapType map, CombineType combine) const
+    {
+        return scheduler.parallelReduce(0, size(), chunkSize, identity, map, combine);
+    }
+
+private:
+    static const IntegerType chunkSize = 4096;
+
+    struct Entry
+    {
+        IntegerType cell;
+        IntegerType neighbours[neighboursCount];
+    };
+
+    inline IntegerType storageIndex(const IntegerType i, const IntegerType j, const IntegerType k) const
+    {
+        return m_layout.index(i + haloWidth, j + haloWidth, k + haloWidth);
+    }
+
+    inline Entry entry(const IntegerType i, const IntegerType j, const IntegerType k) const
+    {
+        Entry result;
+
+        result.cell = storageIndex(i, j, k);
+        result.neighbours[iMinusNeighbour] = storageIndex(i - 1, j, k);
+        result.neighbours[iPlusNeighbour] = storageIndex(i + 1, j, k);
+        result.neighbours[jMinusNeighbour] = storageIndex(i, j - 1, k);
+        result.neighbours[jPlusNeighbour] = storageIndex(i, j + 1, k);
+        result.neighbours[kMinusNeighbour] = storageIndex(i, j, k - 1);
+        result.neighbours[kPlusNeighbour] = storageIndex(i, j, k + 1);
+
+        return result;
+    }
+
+    static inline bool continues(const Entry& previous, const Entry& current)
+    {
+        for (IntegerType neighbour = 0; neighbour < neighboursCount; ++neighbour)
+        {
+            if (current.neighbours[neighbour] != previous.neighbours[neighbour] + 1)
+            {
+                return false;
+            }
+        }
+
+        return current.cell == previous.cell + 1;
+    }
+
+private:
+    const DefaultGridLayout m_layout;
+
+    std::vector<IntegerType> m_cells;
+    std::vector<IntegerType> m_neighbours;
+    std::vector<IntegerType> m_runStarts;
+};
+
+}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../CellFlags.hpp"
+#include "../GridOperations.hpp"
+#include "../IMovement.hpp"
+#include "../ParallelGridOperations.hpp"
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// Evaluates the fluid and solid predicates once per step into the cell flags grid,
+// which has to have a halo. Cells of the halo are solid.
+
+template <typename FluidPredicateSpaceType, typename SolidPredicateSpaceType>
+class CellClassificationMovement
+    : public IMovement
+{
+public:
+    CellClassificationMovement(
+        const CellFlagsGridPtr& cellFlags,
+        const FluidPredicateSpaceType& fluidPredicate,
+        const SolidPredicateSpaceType& solidPredicate)
+        : CellClassificationMovement(cellFlags, fluidPredicate, solidPredicate, std::make_shared<TaskScheduler>(1))
+    {
+    }
+
+    CellClassificationMovement(
+        const CellFlagsGridPtr& cellFlags,
+        const FluidPredicateSpaceType& fluidPredicate,
+        const SolidPredicateSpaceType& solidPredicate,
+        const TaskSchedulerPtr& scheduler)
+        : m_cellFlags(cellFlags)
+        , m_fluidPredicate(fluidPredicate)
+        , m_solidPredicate(solidPredicate)
+        , m_scheduler(scheduler)
+    {
+    }
+
+    CellClassificationMovement(const CellClassificationMovement&) = delete;
+    CellClassificationMovement& operator=(const CellClassificationMovement&) = delete;
+
+    virtual void move(const FloatType) override
+    {
+        CellFlagsGrid& cellFlags = *m_cellFlags;
+
+        parallelForEachIndex(*m_scheduler, cellFlags, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            CellFlags flags = 0;
+
+            if (m_fluidPredicate.at(i, j, k))
+            {
+                flags |= fluidCellFlag;
+            }
+
+            if (m_solidPredicate.at(i, j, k))
+            {
+                flags |= solidCellFlag;
+            }
+
+            cellFlags.at(i, j, k) = flags;
+        });
+
+        fillHalo(cellFlags, ConstantHaloPolicy<CellFlags>(solidCellFlag));
+    }
+
+private:
+    const CellFlagsGridPtr m_cellFlags;
+
+    const FluidPredicateSpaceType m_fluidPredicate;
+    const SolidPredicateSpaceType m_solidPredicate;
+
+    const TaskSchedulerPtr m_scheduler;
+};
+
+}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "FluidComponents.hpp"
+#include "MiccgZeroSolverBase.hpp"
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// MIC(0) preconditioned conjugate gradients over the connected components of the fluid.
+// Splashes break the fluid into many droplets and blobs with independent pressure systems,
+// a single system converges at the pace of its worst component and keeps iterating over
+// the ones that are done. The solver solves the components of up to directSolveCellsCount
+// cells directly, see MiccgZeroKernel::solveSmallComponents, and iterates the others with
+// their own steps and stop rates, see MiccgZeroKernel::solveComponents. Otherwise it works
+// as MiccgZeroSolver, see MiccgZeroSolverBase.
+
+template <typename PredicateSpaceType, typename CoefficientsType = FloatsFourDVectorGrid>
+class ComponentMiccgZeroSolver
+    : public MiccgZeroSolverBase<PredicateSpaceType, CoefficientsType>
+{
+public:
+    typedef MiccgZeroSolverBase<PredicateSpaceType, CoefficientsType> BaseType;
+    typedef typename BaseType::CoefficientsConstPtr CoefficientsConstPtr;
+
+    static const IntegerType defaultDirectSolveCellsCount = 64;
+
+    ComponentMiccgZeroSolver(
+        const FloatsGridPtr& pressure,
+        const PredicateSpaceType& predicate,
+        const CoefficientsConstPtr& coefficients,
+        const FloatsGridConstPtr& rhs,
+        const FloatType tolerance,
+        const IntegerType maxIterations,
+        const GridArenaPtr& arena = std::make_shared<GridArena>(),
+        const TaskSchedulerPtr& scheduler = std::make_shared<TaskScheduler>(1),
+        const bool warmStart = false,
+        const IntegerType directSolveCellsCount = defaultDirectSolveCellsCount)
+        : BaseType(pressure, predicate, coefficients, rhs, tolerance, maxIterations, arena, scheduler, warmStart)
+        , m_directSolveCellsCount(directSolveCellsCount)
+    {
+    }
+
+private:
+    typedef typename BaseType::KernelType KernelType;
+
+    virtual void iterate(FloatsGrid& solution, FloatsGrid& residual, const ActiveCellsList& activeCells) override
+    {
+        const FluidComponents components(*this->m_scheduler, this->m_pressure->res(), activeCells);
+
+        KernelType::solveSmallComponents(*this->m_scheduler, solution, residual, *this->m_coefficients, activeCells, components,
+            m_directSolveCellsCount);
+
+        if (!this->meetsTolerance(residual, activeCells))
+        {
+            this->m_kernel.solveComponents(solution, residual, *this->m_coefficients, this->preconditioner(), activeCells,
+                components, m_directSolveCellsCount, this->m_tolerance, this->m_maxIterations);
+        }
+    }
+
+private:
+    const IntegerType m_directSolveCellsCount;
+};
+
+}
+
+}
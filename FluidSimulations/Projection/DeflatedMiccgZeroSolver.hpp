@@ -0,0 +1,153 @@
+#pragma once
+
+#include "MiccgZeroSolverBase.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// MIC(0) preconditioned deflated conjugate gradients, see MiccgZeroKernel::solveDeflated.
+// The solver keeps the solutions of its last subspaceSize solves, consecutive pressure
+// systems are nearly the same, so their span holds the smooth global modes which converge
+// slowest. A solve restricts the kept solutions to the predicate, orthonormalizes them in
+// the inner product of the current matrix, dropping the nearly dependent ones, starts from
+// the best combination of them and keeps its search directions out of their span.
+//
+// Otherwise the solver works as MiccgZeroSolver, see MiccgZeroSolverBase.
+
+template <typename PredicateSpaceType, typename CoefficientsType = FloatsFourDVectorGrid>
+class DeflatedMiccgZeroSolver
+    : public MiccgZeroSolverBase<PredicateSpaceType, CoefficientsType>
+{
+public:
+    typedef MiccgZeroSolverBase<PredicateSpaceType, CoefficientsType> BaseType;
+    typedef typename BaseType::CoefficientsConstPtr CoefficientsConstPtr;
+
+    static const IntegerType defaultSubspaceSize = 4;
+
+    DeflatedMiccgZeroSolver(
+        const FloatsGridPtr& pressure,
+        const PredicateSpaceType& predicate,
+        const CoefficientsConstPtr& coefficients,
+        const FloatsGridConstPtr& rhs,
+        const FloatType tolerance,
+        const IntegerType maxIterations,
+        const GridArenaPtr& arena = std::make_shared<GridArena>(),
+        const TaskSchedulerPtr& scheduler = std::make_shared<TaskScheduler>(1),
+        const bool warmStart = false,
+        const IntegerType subspaceSize = defaultSubspaceSize)
+        : BaseType(pressure, predicate, coefficients, rhs, tolerance, maxIterations, arena, scheduler, warmStart)
+        , m_subspaceSize(subspaceSize)
+        , m_nextSolution(0)
+    {
+    }
+
+private:
+    typedef typename BaseType::KernelType KernelType;
+
+    virtual void iterate(FloatsGrid& solution, FloatsGrid& residual, const ActiveCellsList& activeCells) override
+    {
+        std::vector<FloatsGridPtr> buffers;
+        std::vector<const FloatsGrid*> basis;
+        std::vector<const FloatsGrid*> products;
+
+        calculateBasis(activeCells, buffers, basis, products);
+
+        KernelType::deflate(*this->m_scheduler, solution, residual, basis, products, activeCells);
+
+        if (!this->meetsTolerance(residual, activeCells))
+        {
+            this->m_kernel.solveDeflated(solution, residual, *this->m_coefficients, this->preconditioner(), basis, products,
+                activeCells, this->m_tolerance, this->m_maxIterations);
+        }
+
+        keepSolution(solution);
+    }
+
+    // The kept solutions over the predicate, orthonormal in the inner product of the matrix,
+    // and the products of the matrix with them.
+
+    void calculateBasis(const ActiveCellsList& activeCells, std::vector<FloatsGridPtr>& buffers,
+        std::vector<const FloatsGrid*>& basis, std::vector<const FloatsGrid*>& products)
+    {
+        TaskScheduler& scheduler = *this->m_scheduler;
+
+        const FloatType dependenceTolerance = std::sqrt(std::numeric_limits<FloatType>::epsilon());
+
+        for (const FloatsGridPtr& kept : m_solutions)
+        {
+            const FloatsGridPtr vector = this->m_arena->template checkOut<FloatsGrid>(this->m_pressure->res(), GridHalo(1));
+            const FloatsGridPtr product = this->m_arena->template checkOut<FloatsGrid>(this->m_pressure->res(), GridHalo(1));
+
+            setValues<FloatType>(vector, 0);
+            KernelType::sumIn(scheduler, *vector, 1, *kept, 0, *kept, activeCells);
+
+            KernelType::applyMatrix(scheduler, *product, *this->m_coefficients, *vector, activeCells);
+
+            const FloatType keptNorm = KernelType::multiply(scheduler, *vector, *product, activeCells);
+
+            std::vector<FloatType> factors = KernelType::multiply(scheduler, *vector, products, activeCells);
+
+            for (FloatType& factor : factors)
+            {
+                factor = -factor;
+            }
+
+            KernelType::sumIn(scheduler, *vector, 1, *vector, 0, *vector, factors, basis, activeCells);
+            KernelType::sumIn(scheduler, *product, 1, *product, 0, *product, factors, products, activeCells);
+
+            const FloatType norm = KernelType::multiply(scheduler, *vector, *product, activeCells);
+
+            if (!(norm > dependenceTolerance * keptNorm))
+            {
+                continue;
+            }
+
+            const FloatType scale = 1 / std::sqrt(norm);
+
+            KernelType::sumIn(scheduler, *vector, scale, *vector, 0, *vector, activeCells);
+            KernelType::sumIn(scheduler, *product, scale, *product, 0, *product, activeCells);
+
+            buffers.push_back(vector);
+            buffers.push_back(product);
+
+            basis.push_back(vector.get());
+            products.push_back(product.get());
+        }
+    }
+
+    void keepSolution(const FloatsGrid& solution)
+    {
+        if (m_subspaceSize <= 0)
+        {
+            return;
+        }
+
+        if (static_cast<IntegerType>(m_solutions.size()) < m_subspaceSize)
+        {
+            m_solutions.push_back(this->m_arena->template checkOut<FloatsGrid>(solution.res(), GridHalo(1)));
+        }
+
+        FloatsGrid& kept = *m_solutions[m_nextSolution];
+        std::copy(solution.data(), solution.data() + solution.storageSize(), kept.data());
+
+        m_nextSolution = (m_nextSolution + 1) % m_subspaceSize;
+    }
+
+private:
+    const IntegerType m_subspaceSize;
+
+    std::vector<FloatsGridPtr> m_solutions;
+    IntegerType m_nextSolution;
+};
+
+}
+
+}
@@ -0,0 +1,301 @@
+#pragma once
+
+#include "../Grid.hpp"
+#include "../GridOperations.hpp"
+#include "../ParallelGridOperations.hpp"
+#include "IPressureSolver.hpp"
+#include "MiccgZeroKernel.hpp"
+
+#include <Eigen/IterativeLinearSolvers>
+#include <Eigen/SparseCholesky>
+#include <Eigen/SparseCore>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <vector>
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// The pressure system assembled over the active cells into an Eigen sparse matrix, for a
+// baseline of the solvers of the library and for small stiff scenes. Systems of up to
+// directSolveCellsCount cells are factorized by SimplicialLDLT, whose fill grows fast in
+// 3D, so it pays off for a few thousand cells at most. The larger systems, and the ones
+// whose factorization fails or leaves a vanishing pivot, are solved by Eigen's conjugate
+// gradients with the IncompleteCholesky preconditioner. The symbolic analysis of both is
+// kept while the active cells, which define the pattern, stay the same. Eigen runs single
+// threaded unless it is built with OpenMP.
+//
+// A warm start keeps the pressure of the previous solve when it meets the tolerance
+// already, and starts the conjugate gradients from it otherwise.
+//
+// Eigen stops the conjugate gradients at a relative residual norm, the solver gives it the
+// tolerance over the norm of the rhs, so the max abs of the residual ends up below the
+// tolerance as with the other solvers. The header needs Eigen on the include path, so the
+// library header does not include it.
+
+template <typename PredicateSpaceType, typename CoefficientsType = FloatsFourDVectorGrid>
+class EigenPressureSolver
+    : public IPressureSolver
+{
+public:
+    typedef std::shared_ptr<const CoefficientsType> CoefficientsConstPtr;
+
+    static const IntegerType defaultDirectSolveCellsCount = 2048;
+
+    EigenPressureSolver(
+        const FloatsGridPtr& pressure,
+        const PredicateSpaceType& predicate,
+        const CoefficientsConstPtr& coefficients,
+        const FloatsGridConstPtr& rhs,
+        const FloatType tolerance,
+        const IntegerType maxIterations,
+        const TaskSchedulerPtr& scheduler = std::make_shared<TaskScheduler>(1),
+        const bool warmStart = false,
+        const IntegerType directSolveCellsCount = defaultDirectSolveCellsCount)
+        : m_pressure(pressure)
+        , m_predicate(predicate)
+        , m_coefficients(coefficients)
+        , m_rhs(rhs)
+        , m_tolerance(tolerance)
+        , m_maxIterations(maxIterations)
+        , m_warmStart(warmStart)
+        , m_directSolveCellsCount(directSolveCellsCount)
+        , m_scheduler(scheduler)
+        , m_indices(pressure->iRes(), pressure->jRes(), pressure->kRes(), GridHalo(1))
+        , m_directAnalyzed(false)
+        , m_iterativeAnalyzed(false)
+    {
+        assert(ActiveCellsList::sharesIndices(*coefficients, pressure->res()));
+    }
+
+    EigenPressureSolver(const EigenPressureSolver&) = delete;
+    EigenPressureSolver& operator=(const EigenPressureSolver&) = delete;
+
+    virtual void solve() override
+    {
+        TaskScheduler& scheduler = *m_scheduler;
+
+        const ActiveCellsList activeCells(scheduler, m_pressure->res(), m_predicate);
+
+        updatePattern(activeCells);
+
+        assemble(activeCells);
+
+        const IntegerType cellsCount = activeCells.size();
+
+        VectorType rhs(cellsCount);
+        VectorType solution(cellsCount);
+
+        gather(*m_rhs, rhs);
+
+        VectorType guess;
+
+        if (m_warmStart)
+        {
+            guess.resize(cellsCount);
+            gather(*m_pressure, guess);
+        }
+
+        if (m_warmStart && (rhs - m_matrix * guess).template lpNorm<Eigen::Infinity>() <= m_tolerance)
+        {
+            solution = guess;
+        }
+        else if (cellsCount > m_directSolveCellsCount || !solveDirectly(rhs, solution))
+        {
+            solveIteratively(rhs, guess, solution);
+        }
+
+        FloatsGrid& pressure = *m_pressure;
+        const Grid<IntegerType>& indices = m_indices;
+
+        parallelForEachIndex(scheduler, pressure, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            const IntegerType index = indices.at(i, j, k);
+
+            pressure.at(i, j, k) = index != absentIndex ? solution[index] : 0;
+        });
+    }
+
+private:
+    typedef MiccgZeroKernel<FloatType, FloatType, PredicateSpaceType> KernelType;
+
+    typedef Eigen::SparseMatrix<FloatType> MatrixType;
+    typedef Eigen::Matrix<FloatType, Eigen::Dynamic, 1> VectorType;
+    typedef Eigen::Triplet<FloatType> TripletType;
+
+    typedef Eigen::SimplicialLDLT<MatrixType> DirectSolverType;
+    typedef Eigen::ConjugateGradient<MatrixType, Eigen::Lower | Eigen::Upper, Eigen::IncompleteCholesky<FloatType>> IterativeSolverType;
+
+    static const IntegerType absentIndex = -1;
+
+    // Maps the storage indices of the active cells to the rows of the matrix, the analysis
+    // of the solvers is dropped when the cells change.
+
+    void updatePattern(const ActiveCellsList& activeCells)
+    {
+        IntegerType* const indexValues = m_indices.data();
+        std::fill(indexValues, indexValues + m_indices.storageSize(), static_cast<IntegerType>(absentIndex));
+
+        bool samePattern = static_cast<IntegerType>(m_patternCells.size()) == activeCells.size();
+
+        m_patternCells.resize(activeCells.size());
+
+        for (IntegerType index = 0; index < activeCells.size(); ++index)
+        {
+            const IntegerType cell = activeCells.cell(index);
+
+            samePattern = samePattern && m_patternCells[index] == cell;
+
+            m_patternCells[index] = cell;
+            indexValues[cell] = index;
+        }
+
+        if (!samePattern)
+        {
+            m_directAnalyzed = false;
+            m_iterativeAnalyzed = false;
+        }
+    }
+
+    // Both triangles of the matrix, a coupling between two active cells is kept even when
+    // its coefficient is zero, so the pattern depends on the cells only.
+
+    void assemble(const ActiveCellsList& activeCells)
+    {
+        const IntegerType* const indexValues = m_indices.data();
+
+        m_triplets.clear();
+        m_triplets.reserve(activeCells.size() * (ActiveCellsList::neighboursCount + 1));
+
+        for (IntegerType index = 0; index < activeCells.size(); ++index)
+        {
+            FloatType neighbourCoefficients[ActiveCellsList::neighboursCount];
+
+            const FloatType diagonal = KernelType::rowCoefficients(*m_coefficients, activeCells, index, neighbourCoefficients);
+
+            m_triplets.push_back(TripletType(index, index, diagonal));
+
+            for (IntegerType neighbour = 0; neighbour < ActiveCellsList::neighboursCount; ++neighbour)
+            {
+                const IntegerType neighbourIndex = indexValues[activeCells.neighbour(index, static_cast<ActiveCellsList::Neighbour>(neighbour))];
+
+                if (neighbourIndex != absentIndex)
+                {
+                    m_triplets.push_back(TripletType(index, neighbourIndex, neighbourCoefficients[neighbour]));
+                }
+            }
+        }
+
+        m_matrix.resize(activeCells.size(), activeCells.size());
+        m_matrix.setFromTriplets(m_triplets.begin(), m_triplets.end());
+    }
+
+    void gather(const FloatsGrid& grid, VectorType& target) const
+    {
+        const Grid<IntegerType>& indices = m_indices;
+
+        parallelForEachIndex(*m_scheduler, grid, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            const IntegerType index = indices.at(i, j, k);
+
+            if (index != absentIndex)
+            {
+                target[index] = grid.at(i, j, k);
+            }
+        });
+    }
+
+    bool solveDirectly(const VectorType& rhs, VectorType& solution)
+    {
+        if (!m_directAnalyzed)
+        {
+            m_direct.analyzePattern(m_matrix);
+            m_directAnalyzed = true;
+        }
+
+        m_direct.factorize(m_matrix);
+
+        // SimplicialLDLT does not pivot, a pivot which vanishes against the diagonal, as for
+        // a component without air whose pressure is defined up to a constant, or a negative
+        // one makes the factorization useless.
+
+        const FloatType pivotTolerance = 16 * std::numeric_limits<FloatType>::epsilon() * m_matrix.diagonal().cwiseAbs().maxCoeff();
+
+        if (m_direct.info() != Eigen::Success || !(m_direct.vectorD().array() > pivotTolerance).all())
+        {
+            return false;
+        }
+
+        solution = m_direct.solve(rhs);
+
+        return m_direct.info() == Eigen::Success;
+    }
+
+    // The guess is used for a warm start only.
+
+    void solveIteratively(const VectorType& rhs, const VectorType& guess, VectorType& solution)
+    {
+        const FloatType rhsNorm = rhs.norm();
+
+        if (!(rhsNorm > 0))
+        {
+            solution.setZero();
+            return;
+        }
+
+        if (!m_iterativeAnalyzed)
+        {
+            m_iterative.analyzePattern(m_matrix);
+            m_iterativeAnalyzed = true;
+        }
+
+        m_iterative.factorize(m_matrix);
+        m_iterative.setTolerance(m_tolerance / rhsNorm);
+        m_iterative.setMaxIterations(m_maxIterations);
+
+        if (m_warmStart)
+        {
+            solution = m_iterative.solveWithGuess(rhs, guess);
+        }
+        else
+        {
+            solution = m_iterative.solve(rhs);
+        }
+    }
+
+private:
+    const FloatsGridPtr m_pressure;
+
+    const PredicateSpaceType m_predicate;
+
+    const CoefficientsConstPtr m_coefficients;
+    const FloatsGridConstPtr m_rhs;
+
+    const FloatType m_tolerance;
+    const IntegerType m_maxIterations;
+    const bool m_warmStart;
+    const IntegerType m_directSolveCellsCount;
+
+    const TaskSchedulerPtr m_scheduler;
+
+    Grid<IntegerType> m_indices;
+    std::vector<IntegerType> m_patternCells;
+    std::vector<TripletType> m_triplets;
+
+    MatrixType m_matrix;
+
+    DirectSolverType m_direct;
+    IterativeSolverType m_iterative;
+
+    bool m_directAnalyzed;
+    bool m_iterativeAnalyzed;
+};
+
+}
+
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "../Grid.hpp"
+#include "../TaskScheduler.hpp"
+#include "ActiveCellsList.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// Connected components of the cells of an active cells list, two cells are connected when
+// they are face neighbours. The pressure systems of the components do not share unknowns,
+// so they can be solved independently. Components are numbered in the order of their first
+// cells in the list, the cells of a component keep the order of the list.
+
+class FluidComponents
+{
+public:
+    static const IntegerType absentIndex = -1;
+
+    FluidComponents(TaskScheduler& scheduler, const IntegersThreeDVector& resolution, const ActiveCellsList& activeCells)
+        : m_indices(resolution.x, resolution.y, resolution.z, GridHalo(1))
+        , m_components(activeCells.size())
+    {
+        IntegerType* const indexValues = m_indices.data();
+        std::fill(indexValues, indexValues + m_indices.storageSize(), static_cast<IntegerType>(absentIndex));
+
+        activeCells.parallelForChunks(scheduler, [&](const IntegerType begin, const IntegerType end) -> void
+        {
+            for (IntegerType index = begin; index < end; ++index)
+            {
+                indexValues[activeCells.cell(index)] = index;
+            }
+        });
+
+        std::vector<IntegerType> parents(activeCells.size());
+        std::iota(parents.begin(), parents.end(), 0);
+
+        const ActiveCellsList::Neighbour forwardNeighbours[] =
+        {
+            ActiveCellsList::iPlusNeighbour, ActiveCellsList::jPlusNeighbour, ActiveCellsList::kPlusNeighbour
+        };
+
+        for (IntegerType index = 0; index < activeCells.size(); ++index)
+        {
+            for (const ActiveCellsList::Neighbour neighbour : forwardNeighbours)
+            {
+                const IntegerType neighbourIndex = indexValues[activeCells.neighbour(index, neighbour)];
+
+                if (neighbourIndex != absentIndex)
+                {
+                    unite(parents, index, neighbourIndex);
+                }
+            }
+        }
+
+        std::vector<IntegerType> rootComponents(activeCells.size(), static_cast<IntegerType>(absentIndex));
+
+        for (IntegerType index = 0; index < activeCells.size(); ++index)
+        {
+            IntegerType& rootComponent = rootComponents[find(parents, index)];
+
+            if (rootComponent == absentIndex)
+            {
+                rootComponent = static_cast<IntegerType>(m_offsets.size());
+                m_offsets.push_back(0);
+            }
+
+            m_components[index] = rootComponent;
+            ++m_offsets[rootComponent];
+
+            if (index == 0 || m_components[index - 1] != rootComponent)
+            {
+                m_segmentStarts.push_back(index);
+            }
+        }
+
+        m_segmentStarts.push_back(activeCells.size());
+
+        m_offsets.push_back(0);
+
+        IntegerType offset = 0;
+
+        for (IntegerType& count : m_offsets)
+        {
+            const IntegerType nextOffset = offset + count;
+            count = offset;
+            offset = nextOffset;
+        }
+
+        m_cells.resize(activeCells.size());
+
+        std::vector<IntegerType> positions(m_offsets.begin(), m_offsets.end() - 1);
+
+        for (IntegerType index = 0; index < activeCells.size(); ++index)
+        {
+            m_cells[positions[m_components[index]]++] = index;
+        }
+    }
+
+    FluidComponents(const FluidComponents&) = delete;
+    FluidComponents& operator=(const FluidComponents&) = delete;
+
+    inline IntegerType size() const
+    {
+        return static_cast<IntegerType>(m_offsets.size()) - 1;
+    }
+
+    // Component of the cell of the list index.
+
+    inline IntegerType component(const IntegerType index) const
+    {
+        return m_components[index];
+    }
+
+    inline IntegerType cellsCount(const IntegerType component) const
+    {
+        return m_offsets[component + 1] - m_offsets[component];
+    }
+
+    // List indices of the cells of the component, in increasing order.
+
+    inline const IntegerType* cells(const IntegerType component) const
+    {
+        return m_cells.data() + m_offsets[component];
+    }
+
+    // Calls functor(index, count, component) for the parts of [begin, end) of the list whose
+    // cells belong to one component.
+
+    template <typename FunctorType>
+    inline void forEachSegment(const IntegerType begin, const IntegerType end, FunctorType functor) const
+    {
+        auto segment = std::upper_bound(m_segmentStarts.begin(), m_segmentStarts.end(), begin) - 1;
+
+        for (IntegerType index = begin; index < end; ++segment)
+        {
+            const IntegerType segmentEnd = std::min(*(segment + 1), end);
+
+            functor(index, segmentEnd - index, m_components[index]);
+
+            index = segmentEnd;
+        }
+    }
+
+    // List index of the cell of the storage index, absentIndex for the cells out of the list.
+
+    inline IntegerType index(const IntegerType cell) const
+    {
+        return m_indices.data()[cell];
+    }
+
+private:
+    static IntegerType find(std::vector<IntegerType>& parents, IntegerType index)
+    {
+        while (parents[index] != index)
+        {
+            parents[index] = parents[parents[index]];
+            index = parents[index];
+        }
+
+        return index;
+    }
+
+    static void unite(std::vector<IntegerType>& parents, const IntegerType left, const IntegerType right)
+    {
+        const IntegerType leftRoot = find(parents, left);
+        const IntegerType rightRoot = find(parents, right);
+
+        if (leftRoot < rightRoot)
+        {
+            parents[rightRoot] = leftRoot;
+        }
+        else
+        {
+            parents[leftRoot] = rightRoot;
+        }
+    }
+
+private:
+    Grid<IntegerType> m_indices;
+
+    std::vector<IntegerType> m_components;
+    std::vector<IntegerType> m_offsets;
+    std::vector<IntegerType> m_cells;
+    std::vector<IntegerType> m_segmentStarts;
+};
+
+}
+
+}
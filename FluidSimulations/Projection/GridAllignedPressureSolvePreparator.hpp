@@ -1,7 +1,13 @@
 #pragma once
 
 #include "../GridOperations.hpp"
+#include "../MacVelocityGrid.hpp"
+#include "ActiveCellsList.hpp"
 #include "IPressureSolverPreparator.hpp"
+#include "PressureStencilGrid.hpp"
+
+#include <algorithm>
+#include <cassert>
 
 namespace FluidSimulations
 {
@@ -14,7 +20,8 @@ template
     typename FluidPredicateSpaceType, 
     typename SolidPredicateSpaceType, 
     typename AirPredicateSpaceType, 
-    typename FloatsThreeDVectorSpaceType
+    typename FloatsThreeDVectorSpaceType,
+    typename CoefficientsType = FloatsFourDVectorGrid
 >
 class GridAllignedPressureSolvePreparator
     : public IPressureSolverPreparator
@@ -22,13 +29,13 @@ class GridAllignedPressureSolvePreparator
 public:
     GridAllignedPressureSolvePreparator(
         const IntegersThreeDVector& resolution, 
-        const FloatsThreeDVectorGridConstPtr& velocity,
+        const MacVelocityGridConstPtr& velocity,
         const FluidPredicateSpaceType& fluidPredicate, 
         const SolidPredicateSpaceType& solidPredicate, 
         const AirPredicateSpaceType& airPredicate,
         const FloatsThreeDVectorSpaceType& solidVelocity, 
         const FloatType fluidDensity,
-        const FloatsFourDVectorGridPtr& coefficients,
+        const std::shared_ptr<CoefficientsType>& coefficients,
         const FloatsGridPtr& rhs)
         : m_velocity(velocity)
         , m_fluidPredicate(fluidPredicate)
@@ -38,7 +45,10 @@ public:
         , m_fluidDensity(fluidDensity)
         , m_coefficients(coefficients)
         , m_rhs(rhs)
-    {}
+    {
+        assert(ActiveCellsList::sharesIndices(*coefficients, resolution));
+        static_cast<void>(resolution);
+    }
 
     GridAllignedPressureSolvePreparator(const GridAllignedPressureSolvePreparator&) = delete;
     GridAllignedPressureSolvePreparator& operator=(const GridAllignedPressureSolvePreparator&) = delete;
@@ -46,7 +56,7 @@ public:
     virtual void prepare(const FloatType timeInterval) override
     {
         calculateRightHandSide();
-        calculateCoefficients(timeInterval);
+        calculateCoefficients(timeInterval, *m_coefficients);
     }
 
 private:
@@ -54,6 +64,10 @@ private:
     {
         setValues<FloatType>(m_rhs, 0);
 
+        const FloatsGrid& iVelocity = m_velocity->iComponent();
+        const FloatsGrid& jVelocity = m_velocity->jComponent();
+        const FloatsGrid& kVelocity = m_velocity->kComponent();
+
         for (IntegerType i = 0; i < m_rhs->iRes(); ++i)
         {
             for (IntegerType j = 0; j < m_rhs->jRes(); ++j)
@@ -65,38 +79,38 @@ private:
                         continue;
                     }
 
-                    FloatType targetValue = m_velocity->at(i, j, k).x - m_velocity->at(i + 1, j, k).x
-                        + m_velocity->at(i, j, k).y - m_velocity->at(i, j + 1, k).y
-                        + m_velocity->at(i, j, k).z - m_velocity->at(i, j, k + 1).z;
+                    FloatType targetValue = iVelocity.at(i, j, k) - iVelocity.at(i + 1, j, k)
+                        + jVelocity.at(i, j, k) - jVelocity.at(i, j + 1, k)
+                        + kVelocity.at(i, j, k) - kVelocity.at(i, j, k + 1);
 
                     if (m_solidPredicate.at(i - 1, j, k))
                     {
-                        targetValue -= m_velocity->at(i, j, k).x - m_solidVelocity.at(i, j, k).x;
+                        targetValue -= iVelocity.at(i, j, k) - m_solidVelocity.at(i, j, k).x;
                     }
 
                     if (m_solidPredicate.at(i + 1, j, k))
                     {
-                        targetValue += m_velocity->at(i + 1, j, k).x - m_solidVelocity.at(i + 1, j, k).x;
+                        targetValue += iVelocity.at(i + 1, j, k) - m_solidVelocity.at(i + 1, j, k).x;
                     }
 
                     if (m_solidPredicate.at(i, j - 1, k))
                     {
-                        targetValue -= m_velocity->at(i, j, k).y - m_solidVelocity.at(i, j, k).y;
+                        targetValue -= jVelocity.at(i, j, k) - m_solidVelocity.at(i, j, k).y;
                     }
 
                     if (m_solidPredicate.at(i, j + 1, k))
                     {
-                        targetValue += m_velocity->at(i, j + 1, k).y - m_solidVelocity.at(i, j + 1, k).y;
+                        targetValue += jVelocity.at(i, j + 1, k) - m_solidVelocity.at(i, j + 1, k).y;
                     }
 
                     if (m_solidPredicate.at(i, j, k - 1))
                     {
-                        targetValue -= m_velocity->at(i, j, k).z - m_solidVelocity.at(i, j, k).z;
+                        targetValue -= kVelocity.at(i, j, k) - m_solidVelocity.at(i, j, k).z;
                     }
 
                     if (m_solidPredicate.at(i, j, k + 1))
                     {
-                        targetValue += m_velocity->at(i, j, k + 1).z - m_solidVelocity.at(i, j, k + 1).z;
+                        targetValue += kVelocity.at(i, j, k + 1) - m_solidVelocity.at(i, j, k + 1).z;
                     }
 
                     m_rhs->at(i, j, k) = targetValue;
@@ -105,80 +119,144 @@ private:
         }
     }
 
-    void calculateCoefficients(const FloatType timeInterval)
+    void calculateCoefficients(const FloatType timeInterval, FloatsFourDVectorGrid& coefficients)
     {
         const FloatType scale = timeInterval / m_fluidDensity;
 
-        setValues<FloatsFourDVector>(m_coefficients, FloatsFourDVector());
+        std::fill(coefficients.data(), coefficients.data() + coefficients.storageSize(), FloatsFourDVector());
 
-        for (IntegerType i = 0; i < m_coefficients->iRes(); ++i)
+        for (IntegerType i = 0; i < coefficients.iRes(); ++i)
         {
-            for (IntegerType j = 0; j < m_coefficients->jRes(); ++j)
+            for (IntegerType j = 0; j < coefficients.jRes(); ++j)
             {
-                for (IntegerType k = 0; k < m_coefficients->kRes(); ++k)
+                for (IntegerType k = 0; k < coefficients.kRes(); ++k)
                 {
                     if (!m_fluidPredicate.at(i, j, k))
                     {
                         continue;
                     }
 
-                    if ((i < m_coefficients->iRes() - 1) && m_fluidPredicate.at(i + 1, j, k))
+                    if ((i < coefficients.iRes() - 1) && m_fluidPredicate.at(i + 1, j, k))
                     {
-                        m_coefficients->at(i, j, k).x += scale;
-                        m_coefficients->at(i + 1, j, k).x += scale;
-                        m_coefficients->at(i, j, k).y = -scale;
+                        coefficients.at(i, j, k).x += scale;
+                        coefficients.at(i + 1, j, k).x += scale;
+                        coefficients.at(i, j, k).y = -scale;
                     }
 
                     if (m_airPredicate.at(i + 1, j, k))
                     {
-                        m_coefficients->at(i, j, k).x += scale;
+                        coefficients.at(i, j, k).x += scale;
                     }
 
                     if (m_airPredicate.at(i - 1, j, k))
                     {
-                        m_coefficients->at(i, j, k).x += scale;
+                        coefficients.at(i, j, k).x += scale;
                     }
 
-                    if ((j < m_coefficients->jRes() - 1) && m_fluidPredicate.at(i, j + 1, k))
+                    if ((j < coefficients.jRes() - 1) && m_fluidPredicate.at(i, j + 1, k))
                     {
-                        m_coefficients->at(i, j, k).x += scale;
-                        m_coefficients->at(i, j + 1, k).x += scale;
-                        m_coefficients->at(i, j, k).z = -scale;
+                        coefficients.at(i, j, k).x += scale;
+                        coefficients.at(i, j + 1, k).x += scale;
+                        coefficients.at(i, j, k).z = -scale;
                     }
 
                     if (m_airPredicate.at(i, j + 1, k))
                     {
-                        m_coefficients->at(i, j, k).x += scale;
+                        coefficients.at(i, j, k).x += scale;
                     }
 
                     if (m_airPredicate.at(i, j - 1, k))
                     {
-                        m_coefficients->at(i, j, k).x += scale;
+                        coefficients.at(i, j, k).x += scale;
                     }
 
-                    if ((k < m_coefficients->kRes() - 1) && m_fluidPredicate.at(i, j, k + 1))
+                    if ((k < coefficients.kRes() - 1) && m_fluidPredicate.at(i, j, k + 1))
                     {
-                        m_coefficients->at(i, j, k).x += scale;
-                        m_coefficients->at(i, j, k + 1).x += scale;
-                        m_coefficients->at(i, j, k).w = -scale;
+                        coefficients.at(i, j, k).x += scale;
+                        coefficients.at(i, j, k + 1).x += scale;
+                        coefficients.at(i, j, k).w = -scale;
                     }
 
                     if (m_airPredicate.at(i, j, k + 1))
                     {
-                        m_coefficients->at(i, j, k).x += scale;
+                        coefficients.at(i, j, k).x += scale;
                     }
 
                     if (m_airPredicate.at(i, j, k - 1))
                     {
-                        m_coefficients->at(i, j, k).x += scale;
+                        coefficients.at(i, j, k).x += scale;
                     }
                 }
             }
         }
     }
 
+    // The stencil of a fluid cell marks its fluid neighbours and counts its fluid and air
+    // neighbours, as the coefficients above do.
+
+    void calculateCoefficients(const FloatType timeInterval, PressureStencilGrid& coefficients)
+    {
+        coefficients.setScale(timeInterval / m_fluidDensity);
+
+        PressureStencilsGrid& stencils = coefficients.stencils();
+
+        std::fill(stencils.data(), stencils.data() + stencils.storageSize(), PressureStencil(0));
+
+        for (IntegerType i = 0; i < stencils.iRes(); ++i)
+        {
+            for (IntegerType j = 0; j < stencils.jRes(); ++j)
+            {
+                for (IntegerType k = 0; k < stencils.kRes(); ++k)
+                {
+                    if (!m_fluidPredicate.at(i, j, k))
+                    {
+                        continue;
+                    }
+
+                    const bool fluidNeighbours[ActiveCellsList::neighboursCount] =
+                    {
+                        (i > 0) && m_fluidPredicate.at(i - 1, j, k),
+                        (i < stencils.iRes() - 1) && m_fluidPredicate.at(i + 1, j, k),
+                        (j > 0) && m_fluidPredicate.at(i, j - 1, k),
+                        (j < stencils.jRes() - 1) && m_fluidPredicate.at(i, j + 1, k),
+                        (k > 0) && m_fluidPredicate.at(i, j, k - 1),
+                        (k < stencils.kRes() - 1) && m_fluidPredicate.at(i, j, k + 1)
+                    };
+
+                    const bool airNeighbours[ActiveCellsList::neighboursCount] =
+                    {
+                        m_airPredicate.at(i - 1, j, k),
+                        m_airPredicate.at(i + 1, j, k),
+                        m_airPredicate.at(i, j - 1, k),
+                        m_airPredicate.at(i, j + 1, k),
+                        m_airPredicate.at(i, j, k - 1),
+                        m_airPredicate.at(i, j, k + 1)
+                    };
+
+                    PressureStencil stencil = 0;
+                    PressureStencil diagonal = 0;
+
+                    for (IntegerType neighbour = 0; neighbour < ActiveCellsList::neighboursCount; ++neighbour)
+                    {
+                        if (fluidNeighbours[neighbour])
+                        {
+                            stencil |= 1 << neighbour;
+                            ++diagonal;
+                        }
+                        else if (airNeighbours[neighbour])
+                        {
+                            ++diagonal;
+                        }
+                    }
+
+                    stencils.at(i, j, k) = stencil | diagonal << PressureStencilGrid::diagonalShift;
+                }
+            }
+        }
+    }
+
 private:
-    const FloatsThreeDVectorGridConstPtr m_velocity;
+    const MacVelocityGridConstPtr m_velocity;
 
     const FluidPredicateSpaceType m_fluidPredicate;
     const SolidPredicateSpaceType m_solidPredicate;
@@ -187,7 +265,7 @@ private:
     
     const FloatType m_fluidDensity;
 
-    const FloatsFourDVectorGridPtr m_coefficients;
+    const std::shared_ptr<CoefficientsType> m_coefficients;
     const FloatsGridPtr m_rhs;
 };
 
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../CellFlagsPredicate.hpp"
+#include "MiccgZeroSolverBase.hpp"
+#include "MultigridPreconditioner.hpp"
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// Conjugate gradient iterations preconditioned by a multigrid V-cycle, the iterations
+// count hardly grows with the resolution. The coefficients have to be prepared over
+// the fluid cells of the cell flags, which have to have a halo one cell wide. Otherwise
+// the solver works as MiccgZeroSolver, see MiccgZeroSolverBase, the MIC(0)
+// preconditioner of the base is not used.
+
+class MgpcgSolver
+    : public MiccgZeroSolverBase<CellFlagsPredicate, FloatsFourDVectorGrid>
+{
+public:
+    typedef MiccgZeroSolverBase<CellFlagsPredicate, FloatsFourDVectorGrid> BaseType;
+
+    MgpcgSolver(
+        const FloatsGridPtr& pressure,
+        const CellFlagsGridConstPtr& cellFlags,
+        const FloatsFourDVectorGridConstPtr& coefficients,
+        const FloatsGridConstPtr& rhs,
+        const FloatType tolerance,
+        const IntegerType maxIterations,
+        const GridArenaPtr& arena = std::make_shared<GridArena>(),
+        const TaskSchedulerPtr& scheduler = std::make_shared<TaskScheduler>(1),
+        const bool warmStart = false)
+        : BaseType(pressure, CellFlagsPredicate::fluid(cellFlags), coefficients, rhs, tolerance, maxIterations,
+            arena, scheduler, warmStart)
+        , m_preconditioner(cellFlags, coefficients, arena, scheduler)
+    {
+    }
+
+private:
+    virtual void iterate(FloatsGrid& solution, FloatsGrid& residual, const ActiveCellsList& activeCells) override
+    {
+        if (!meetsTolerance(residual, activeCells))
+        {
+            m_preconditioner.prepare();
+
+            m_kernel.solvePreconditioned(solution, residual, *m_coefficients, activeCells,
+                [this](FloatsGrid& target, const FloatsGrid& source) -> void
+            {
+                m_preconditioner.apply(target, source);
+            }, m_tolerance, m_maxIterations);
+
+            m_preconditioner.release();
+        }
+    }
+
+private:
+    MultigridPreconditioner m_preconditioner;
+};
+
+}
+
+}
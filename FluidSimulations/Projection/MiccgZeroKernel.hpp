@@ -0,0 +1,1514 @@
+#pragma once
+
+#include "../GridArena.hpp"
+#include "../GridOperations.hpp"
+#include "../ParallelGridOperations.hpp"
+#include "../TaskScheduler.hpp"
+#include "ActiveCellsList.hpp"
+#include "FluidComponents.hpp"
+#include "PressureStencilGrid.hpp"
+#include "SimdRunOperations.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// Conjugate gradient iterations preconditioned by modified incomplete Cholesky MIC(0),
+// vectors and coefficients are stored in ScalarType, dot products and the stop rate
+// are accumulated in AccumulatorType.
+//
+// Coefficients of the cells outside of the predicate are expected to be zero and the
+// coefficients grid to have a halo one cell wide, so the stencils read the neighbours
+// without bounds or predicate checks. Work grids are checked out of the arena for the
+// time of a call.
+//
+// The vector operations and the matrix loop over the active cells list of the predicate
+// instead of the whole grid, the grids they take have to have a halo one cell wide, see
+// ActiveCellsList::sharesIndices, which the solvers assert for the coefficients.
+//
+// The coefficients are either a CoefficientsGrid or a PressureStencilGrid, the latter
+// is read through at() outside of the matrix product.
+//
+// The vector operations and the matrix products go over the runs of the active cells
+// list with the instructions of simdLevel(), see SimdRunOperations.
+//
+// The triangular sweeps of the preconditioner run as wavefronts over blocks of columns,
+// see parallelForEachIndexWavefront, every cell sees the same neighbour values as in
+// the lexicographic sweep, so the preconditioner does not depend on the threads count.
+
+template <typename ScalarType, typename AccumulatorType, typename PredicateSpaceType>
+class MiccgZeroKernel
+{
+public:
+    typedef Grid<ScalarType> ScalarsGrid;
+    typedef std::shared_ptr<ScalarsGrid> ScalarsGridPtr;
+
+    typedef Grid<ScalarFourdDVector<ScalarType>> CoefficientsGrid;
+
+    typedef SimdRunOperations<ScalarType, AccumulatorType> RunOperations;
+
+    MiccgZeroKernel(const PredicateSpaceType& predicate, const GridArenaPtr& arena)
+        : MiccgZeroKernel(predicate, arena, std::make_shared<TaskScheduler>(1))
+    {
+    }
+
+    MiccgZeroKernel(const PredicateSpaceType& predicate, const GridArenaPtr& arena, const TaskSchedulerPtr& scheduler)
+        : m_predicate(predicate)
+        , m_arena(arena)
+        , m_scheduler(scheduler)
+    {
+    }
+
+    MiccgZeroKernel(const MiccgZeroKernel&) = delete;
+    MiccgZeroKernel& operator=(const MiccgZeroKernel&) = delete;
+
+    static AccumulatorType calculateStopRate(TaskScheduler& scheduler, const ScalarsGrid& target, const ActiveCellsList& activeCells)
+    {
+        const ScalarType* const values = target.data();
+        const SimdLevel level = simdLevel();
+
+        return activeCells.parallelReduceChunks(scheduler, static_cast<AccumulatorType>(0),
+            [&](const IntegerType begin, const IntegerType end) -> AccumulatorType
+        {
+            AccumulatorType maxAbsValue = 0;
+
+            activeCells.forEachRun(begin, end, [&](const IntegerType index, const IntegerType count) -> void
+            {
+                maxAbsValue = RunOperations::maxAbs(level, maxAbsValue, values + activeCells.cell(index), count);
+            });
+
+            return maxAbsValue;
+        }, [](const AccumulatorType left, const AccumulatorType right) -> AccumulatorType
+        {
+            return std::max(left, right);
+        });
+    }
+
+    // Start of the iterations from zero or from the values of the guess over the predicate,
+    // with its residual. The other cells get zero, the solution has to have a halo one cell
+    // wide.
+
+    static void startFromZero(
+        TaskScheduler& scheduler,
+        ScalarsGrid& solution,
+        ScalarsGrid& residual,
+        const ScalarsGrid& rhs,
+        const PredicateSpaceType& predicate)
+    {
+        std::fill(solution.data(), solution.data() + solution.storageSize(), static_cast<ScalarType>(0));
+
+        parallelForEachIndex(scheduler, residual, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            residual.at(i, j, k) = predicate.at(i, j, k) ? rhs.at(i, j, k) : 0;
+        });
+    }
+
+    template <typename CoefficientsType>
+    static void startFromGuess(
+        TaskScheduler& scheduler,
+        ScalarsGrid& solution,
+        ScalarsGrid& residual,
+        const CoefficientsType& coefficients,
+        const ScalarsGrid& rhs,
+        const ScalarsGrid& guess,
+        const ActiveCellsList& activeCells,
+        const PredicateSpaceType& predicate)
+    {
+        std::fill(solution.data(), solution.data() + solution.storageSize(), static_cast<ScalarType>(0));
+
+        parallelForEachIndex(scheduler, solution, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            if (predicate.at(i, j, k))
+            {
+                solution.at(i, j, k) = guess.at(i, j, k);
+            }
+        });
+
+        calculateResidual(scheduler, residual, coefficients, solution, rhs, activeCells, predicate);
+    }
+
+    // The residual of the solution over the predicate and zero elsewhere, the rhs may have
+    // any halo.
+
+    template <typename CoefficientsType>
+    static void calculateResidual(
+        TaskScheduler& scheduler,
+        ScalarsGrid& residual,
+        const CoefficientsType& coefficients,
+        const ScalarsGrid& solution,
+        const ScalarsGrid& rhs,
+        const ActiveCellsList& activeCells,
+        const PredicateSpaceType& predicate)
+    {
+        applyMatrix(scheduler, residual, coefficients, solution, activeCells);
+
+        parallelForEachIndex(scheduler, residual, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            residual.at(i, j, k) = predicate.at(i, j, k) ? rhs.at(i, j, k) - residual.at(i, j, k) : 0;
+        });
+    }
+
+    // Equal coefficients give equal fingerprints, so a preconditioner can be kept while the
+    // fingerprint stays the same. The preconditioner of other coefficients is still
+    // symmetric positive definite, a collision could slow the iterations down only.
+
+    static std::uint64_t calculateFingerprint(TaskScheduler& scheduler, const CoefficientsGrid& coefficients)
+    {
+        return fingerprint(scheduler, coefficients.data(), coefficients.storageSize() * sizeof(ScalarFourdDVector<ScalarType>));
+    }
+
+    static std::uint64_t calculateFingerprint(TaskScheduler& scheduler, const PressureStencilGrid& coefficients)
+    {
+        const PressureStencilsGrid& stencils = coefficients.stencils();
+        const FloatType scale = coefficients.scale();
+
+        return fingerprint(fingerprint(scheduler, stencils.data(), stencils.storageSize() * sizeof(PressureStencil)), &scale, sizeof(scale));
+    }
+
+    template <typename CoefficientsType>
+    ScalarsGridPtr calculatePreconditioner(const CoefficientsType& coefficients)
+    {
+        constexpr ScalarType tau = 0.97f;
+        constexpr ScalarType sigma = 0.25f;
+
+        const ScalarsGridPtr preconditionerBuffer = checkOutZeroed(coefficients.res());
+        ScalarsGrid& preconditioner = *preconditionerBuffer;
+
+        parallelForEachIndexWavefront(*m_scheduler, preconditioner, true, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            if (!m_predicate.at(i, j, k))
+            {
+                return;
+            }
+
+            const ScalarType aValue = coefficients.at(i, j, k).x;
+
+            const ScalarFourdDVector<ScalarType>& ami = coefficients.at(i - 1, j, k);
+            const ScalarFourdDVector<ScalarType>& amj = coefficients.at(i, j - 1, k);
+            const ScalarFourdDVector<ScalarType>& amk = coefficients.at(i, j, k - 1);
+
+            const ScalarType apimi = ami.y;
+            const ScalarType apjmi = ami.z;
+            const ScalarType apkmi = ami.w;
+
+            const ScalarType apimj = amj.y;
+            const ScalarType apjmj = amj.z;
+            const ScalarType apkmj = amj.w;
+
+            const ScalarType apimk = amk.y;
+            const ScalarType apjmk = amk.z;
+            const ScalarType apkmk = amk.w;
+
+            const ScalarType pmi = preconditioner.at(i - 1, j, k);
+            const ScalarType pmj = preconditioner.at(i, j - 1, k);
+            const ScalarType pmk = preconditioner.at(i, j, k - 1);
+
+            const ScalarType tpi = apimi * pmi;
+            const ScalarType tpj = apjmj * pmj;
+            const ScalarType tpk = apkmk * pmk;
+
+            const ScalarType preTauValue = apimi * (apjmi + apkmi) * pmi * pmi
+                + apjmj * (apimj + apkmj) * pmj * pmj + apkmk * (apimk + apjmk) * pmk * pmk;
+
+            const ScalarType eValue = aValue - tpi * tpi - tpj * tpj - tpk * tpk - tau * preTauValue;
+
+            const ScalarType dValue = eValue < sigma * aValue ? aValue : eValue;
+
+            preconditioner.at(i, j, k) = 1 / std::sqrt(dValue);
+        });
+
+        return preconditionerBuffer;
+    }
+
+    // Improves the solution until the residual, which has to be consistent with it,
+    // drops to the tolerance. The preconditioner has to be calculated beforehand.
+
+    template <typename CoefficientsType>
+    void solve(ScalarsGrid& solution, ScalarsGrid& residual, const CoefficientsType& coefficients,
+        const ScalarsGrid& preconditioner, const ActiveCellsList& activeCells,
+        const AccumulatorType tolerance, const IntegerType maxIterations)
+    {
+        const ScalarsGridPtr factorizationSolveBuffer = checkOutZeroed(solution.res());
+
+        solvePreconditioned(solution, residual, coefficients, activeCells,
+            [&](ScalarsGrid& target, const ScalarsGrid& source) -> void
+        {
+            applyPreconditioner(target, *factorizationSolveBuffer, coefficients, preconditioner, source);
+        }, tolerance, maxIterations);
+    }
+
+    // The same iterations with another preconditioner, precondition(target, source)
+    // has to be a symmetric positive definite operator and to write the cells of the
+    // predicate. Its target has a halo one cell wide.
+
+    template <typename CoefficientsType, typename PreconditionerType>
+    void solvePreconditioned(ScalarsGrid& solution, ScalarsGrid& residual, const CoefficientsType& coefficients,
+        const ActiveCellsList& activeCells, PreconditionerType precondition, const AccumulatorType tolerance, const IntegerType maxIterations)
+    {
+        const ScalarsGridPtr searchBuffer = checkOutZeroed(solution.res());
+        const ScalarsGridPtr auxiliaryBuffer = checkOutZeroed(solution.res());
+
+        ScalarsGrid& search = *searchBuffer;
+        ScalarsGrid& auxiliary = *auxiliaryBuffer;
+
+        precondition(auxiliary, residual);
+
+        copyIn(auxiliary, search);
+
+        TaskScheduler& scheduler = *m_scheduler;
+
+        AccumulatorType sigma = multiply(scheduler, auxiliary, residual, activeCells);
+
+        for (IntegerType iteration = 0; iteration < maxIterations; ++iteration)
+        {
+            const AccumulatorType alpha = sigma / applyMatrixAndMultiply(scheduler, auxiliary, coefficients, search, activeCells);
+
+            const AccumulatorType stopRate = updateSolutionAndResidual(scheduler, solution, residual,
+                static_cast<ScalarType>(alpha), search, auxiliary, activeCells);
+
+            if (stopRate <= tolerance)
+            {
+                return;
+            }
+
+            precondition(auxiliary, residual);
+
+            const AccumulatorType sigmaNew = multiply(scheduler, auxiliary, residual, activeCells);
+
+            const AccumulatorType betta = sigmaNew / sigma;
+
+            sumIn(scheduler, search, 1, auxiliary, static_cast<ScalarType>(betta), search, activeCells);
+
+            sigma = sigmaNew;
+        }
+    }
+
+    // Deflated iterations of Saad, Yeung, Erhel and Guyomarc'h. The basis has to be
+    // orthonormal in the inner product of the matrix and zero outside of the predicate, the
+    // products are the matrix times its vectors. The residual has to be orthogonal to the
+    // basis, see deflate, the search directions are kept orthogonal to it in the inner
+    // product of the matrix, so the iterations do not spend steps on its modes.
+
+    template <typename CoefficientsType>
+    void solveDeflated(ScalarsGrid& solution, ScalarsGrid& residual, const CoefficientsType& coefficients,
+        const ScalarsGrid& preconditioner, const std::vector<const ScalarsGrid*>& basis, const std::vector<const ScalarsGrid*>& products,
+        const ActiveCellsList& activeCells, const AccumulatorType tolerance, const IntegerType maxIterations)
+    {
+        const ScalarsGridPtr factorizationSolveBuffer = checkOutZeroed(solution.res());
+
+        solveDeflatedPreconditioned(solution, residual, coefficients, basis, products, activeCells,
+            [&](ScalarsGrid& target, const ScalarsGrid& source) -> void
+        {
+            applyPreconditioner(target, *factorizationSolveBuffer, coefficients, preconditioner, source);
+        }, tolerance, maxIterations);
+    }
+
+    template <typename CoefficientsType, typename PreconditionerType>
+    void solveDeflatedPreconditioned(ScalarsGrid& solution, ScalarsGrid& residual, const CoefficientsType& coefficients,
+        const std::vector<const ScalarsGrid*>& basis, const std::vector<const ScalarsGrid*>& products,
+        const ActiveCellsList& activeCells, PreconditionerType precondition, const AccumulatorType tolerance, const IntegerType maxIterations)
+    {
+        const ScalarsGridPtr searchBuffer = checkOutZeroed(solution.res());
+        const ScalarsGridPtr auxiliaryBuffer = checkOutZeroed(solution.res());
+
+        ScalarsGrid& search = *searchBuffer;
+        ScalarsGrid& auxiliary = *auxiliaryBuffer;
+
+        TaskScheduler& scheduler = *m_scheduler;
+
+        // The preconditioned residual times the residual and the products in one reduction,
+        // the first dot product gives sigma and the others the components of the basis to
+        // take out of the search direction.
+
+        std::vector<const ScalarsGrid*> multiplied(1, &residual);
+        multiplied.insert(multiplied.end(), products.begin(), products.end());
+
+        std::vector<AccumulatorType> factors(basis.size());
+
+        const auto multiplyPreconditioned = [&]() -> AccumulatorType
+        {
+            const std::vector<AccumulatorType> dots = multiply(scheduler, auxiliary, multiplied, activeCells);
+
+            for (std::size_t vector = 0; vector != factors.size(); ++vector)
+            {
+                factors[vector] = -dots[vector + 1];
+            }
+
+            return dots[0];
+        };
+
+        precondition(auxiliary, residual);
+
+        AccumulatorType sigma = multiplyPreconditioned();
+
+        sumIn(scheduler, search, 1, auxiliary, 0, search, factors, basis, activeCells);
+
+        for (IntegerType iteration = 0; iteration < maxIterations; ++iteration)
+        {
+            const AccumulatorType alpha = sigma / applyMatrixAndMultiply(scheduler, auxiliary, coefficients, search, activeCells);
+
+            const AccumulatorType stopRate = updateSolutionAndResidual(scheduler, solution, residual,
+                static_cast<ScalarType>(alpha), search, auxiliary, activeCells);
+
+            if (stopRate <= tolerance)
+            {
+                return;
+            }
+
+            precondition(auxiliary, residual);
+
+            const AccumulatorType sigmaNew = multiplyPreconditioned();
+
+            const AccumulatorType betta = sigmaNew / sigma;
+
+            sumIn(scheduler, search, 1, auxiliary, static_cast<ScalarType>(betta), search, factors, basis, activeCells);
+
+            sigma = sigmaNew;
+        }
+    }
+
+    // Moves the solution by the part of the error in the span of the basis, which leaves the
+    // residual orthogonal to the basis. The basis and the products are as in solveDeflated.
+
+    static void deflate(
+        TaskScheduler& scheduler,
+        ScalarsGrid& solution,
+        ScalarsGrid& residual,
+        const std::vector<const ScalarsGrid*>& basis,
+        const std::vector<const ScalarsGrid*>& products,
+        const ActiveCellsList& activeCells)
+    {
+        std::vector<AccumulatorType> factors = multiply(scheduler, residual, basis, activeCells);
+
+        sumIn(scheduler, solution, 1, solution, 0, solution, factors, basis, activeCells);
+
+        for (AccumulatorType& factor : factors)
+        {
+            factor = -factor;
+        }
+
+        sumIn(scheduler, residual, 1, residual, 0, residual, factors, products, activeCells);
+    }
+
+    // Solves the systems of the components of up to maxCellsCount cells directly, by the
+    // Cholesky factorization of their dense matrices, and zeroes their residual. A pivot
+    // which vanishes, as in the components without air neighbours, gets a zero unknown and
+    // the residual of such a component is calculated again from its unknowns.
+
+    template <typename CoefficientsType>
+    static void solveSmallComponents(
+        TaskScheduler& scheduler,
+        ScalarsGrid& solution,
+        ScalarsGrid& residual,
+        const CoefficientsType& coefficients,
+        const ActiveCellsList& activeCells,
+        const FluidComponents& components,
+        const IntegerType maxCellsCount)
+    {
+        ScalarType* const solutionValues = solution.data();
+        ScalarType* const residualValues = residual.data();
+
+        scheduler.parallelFor(0, components.size(), 1, [&](const IntegerType begin, const IntegerType end) -> void
+        {
+            std::vector<AccumulatorType> factor;
+            std::vector<AccumulatorType> unknowns;
+
+            for (IntegerType component = begin; component < end; ++component)
+            {
+                const IntegerType cellsCount = components.cellsCount(component);
+
+                if (cellsCount > maxCellsCount)
+                {
+                    continue;
+                }
+
+                const IntegerType* const cells = components.cells(component);
+
+                factor.assign(cellsCount * cellsCount, 0);
+                unknowns.resize(cellsCount);
+
+                for (IntegerType row = 0; row < cellsCount; ++row)
+                {
+                    const IntegerType index = cells[row];
+
+                    ScalarType neighbourCoefficients[ActiveCellsList::neighboursCount];
+
+                    factor[row * cellsCount + row] = rowCoefficients(coefficients, activeCells, index, neighbourCoefficients);
+
+                    for (IntegerType neighbour = 0; neighbour < ActiveCellsList::neighboursCount; ++neighbour)
+                    {
+                        const IntegerType neighbourIndex = components.index(
+                            activeCells.neighbour(index, static_cast<ActiveCellsList::Neighbour>(neighbour)));
+
+                        if (neighbourIndex != FluidComponents::absentIndex)
+                        {
+                            factor[row * cellsCount + componentColumn(cells, cellsCount, neighbourIndex)] = neighbourCoefficients[neighbour];
+                        }
+                    }
+
+                    unknowns[row] = residualValues[activeCells.cell(index)];
+                }
+
+                const bool regular = solveDense(factor, unknowns, cellsCount);
+
+                for (IntegerType row = 0; row < cellsCount; ++row)
+                {
+                    const IntegerType index = cells[row];
+                    const IntegerType cell = activeCells.cell(index);
+
+                    solutionValues[cell] += static_cast<ScalarType>(unknowns[row]);
+
+                    if (regular)
+                    {
+                        residualValues[cell] = 0;
+                        continue;
+                    }
+
+                    ScalarType neighbourCoefficients[ActiveCellsList::neighboursCount];
+
+                    AccumulatorType product = rowCoefficients(coefficients, activeCells, index, neighbourCoefficients) * unknowns[row];
+
+                    for (IntegerType neighbour = 0; neighbour < ActiveCellsList::neighboursCount; ++neighbour)
+                    {
+                        const IntegerType neighbourIndex = components.index(
+                            activeCells.neighbour(index, static_cast<ActiveCellsList::Neighbour>(neighbour)));
+
+                        if (neighbourIndex != FluidComponents::absentIndex)
+                        {
+                            product += neighbourCoefficients[neighbour] * unknowns[componentColumn(cells, cellsCount, neighbourIndex)];
+                        }
+                    }
+
+                    residualValues[cell] -= static_cast<ScalarType>(product);
+                }
+            }
+        });
+    }
+
+    // The iterations of solve run for each component of more than minCellsCount cells with
+    // its own steps and stop rate, as if the components were solved one by one, while the
+    // passes go over all of them at once. A component stops taking part in the passes when
+    // its residual drops to the tolerance, the preconditioner still sweeps the whole grid.
+
+    template <typename CoefficientsType>
+    void solveComponents(ScalarsGrid& solution, ScalarsGrid& residual, const CoefficientsType& coefficients,
+        const ScalarsGrid& preconditioner, const ActiveCellsList& activeCells, const FluidComponents& components,
+        const IntegerType minCellsCount, const AccumulatorType tolerance, const IntegerType maxIterations)
+    {
+        const ScalarsGridPtr factorizationSolveBuffer = checkOutZeroed(solution.res());
+
+        solveComponentsPreconditioned(solution, residual, coefficients, activeCells, components, minCellsCount,
+            [&](ScalarsGrid& target, const ScalarsGrid& source) -> void
+        {
+            applyPreconditioner(target, *factorizationSolveBuffer, coefficients, preconditioner, source);
+        }, tolerance, maxIterations);
+    }
+
+    template <typename CoefficientsType, typename PreconditionerType>
+    void solveComponentsPreconditioned(ScalarsGrid& solution, ScalarsGrid& residual, const CoefficientsType& coefficients,
+        const ActiveCellsList& activeCells, const FluidComponents& components, const IntegerType minCellsCount,
+        PreconditionerType precondition, const AccumulatorType tolerance, const IntegerType maxIterations)
+    {
+        TaskScheduler& scheduler = *m_scheduler;
+
+        ComponentSlots slots(components, minCellsCount);
+
+        const ScalarsGridPtr searchBuffer = checkOutZeroed(solution.res());
+        const ScalarsGridPtr auxiliaryBuffer = checkOutZeroed(solution.res());
+
+        ScalarType* const solutionValues = solution.data();
+        ScalarType* const residualValues = residual.data();
+        ScalarType* const searchValues = searchBuffer->data();
+        ScalarType* const auxiliaryValues = auxiliaryBuffer->data();
+        const SimdLevel level = simdLevel();
+
+        const std::vector<AccumulatorType> initialStopRates = reduceComponents(scheduler, activeCells, slots,
+            [&](const AccumulatorType result, const IntegerType index, const IntegerType count, const IntegerType) -> AccumulatorType
+        {
+            return RunOperations::maxAbs(level, result, residualValues + activeCells.cell(index), count);
+        }, maxOf);
+
+        if (!slots.updateIterated(initialStopRates, tolerance))
+        {
+            return;
+        }
+
+        precondition(*auxiliaryBuffer, residual);
+
+        copyIn(*auxiliaryBuffer, *searchBuffer);
+
+        const auto multiplyAuxiliaryAndResidual =
+            [&](const AccumulatorType result, const IntegerType index, const IntegerType count, const IntegerType) -> AccumulatorType
+        {
+            const IntegerType cell = activeCells.cell(index);
+
+            return RunOperations::multiply(level, result, auxiliaryValues + cell, residualValues + cell, count);
+        };
+
+        std::vector<AccumulatorType> sigmas = reduceComponents(scheduler, activeCells, slots, multiplyAuxiliaryAndResidual, sumOf);
+
+        std::vector<ScalarType> factors(sigmas.size());
+
+        for (IntegerType iteration = 0; iteration < maxIterations; ++iteration)
+        {
+            const std::vector<AccumulatorType> stepDots = reduceComponents(scheduler, activeCells, slots,
+                [&](const AccumulatorType result, const IntegerType index, const IntegerType count, const IntegerType) -> AccumulatorType
+            {
+                return applyMatrixAndMultiplyRun(level, result, auxiliaryValues, coefficients, searchValues, activeCells, index, count);
+            }, sumOf);
+
+            for (std::size_t slot = 0; slot != factors.size(); ++slot)
+            {
+                factors[slot] = static_cast<ScalarType>(sigmas[slot] / stepDots[slot]);
+            }
+
+            const std::vector<AccumulatorType> stopRates = reduceComponents(scheduler, activeCells, slots,
+                [&](const AccumulatorType result, const IntegerType index, const IntegerType count, const IntegerType slot) -> AccumulatorType
+            {
+                const IntegerType cell = activeCells.cell(index);
+
+                return RunOperations::updateSolutionAndResidual(level, result, solutionValues + cell, residualValues + cell,
+                    factors[slot], searchValues + cell, auxiliaryValues + cell, count);
+            }, maxOf);
+
+            if (!slots.updateIterated(stopRates, tolerance))
+            {
+                return;
+            }
+
+            precondition(*auxiliaryBuffer, residual);
+
+            const std::vector<AccumulatorType> sigmasNew = reduceComponents(scheduler, activeCells, slots, multiplyAuxiliaryAndResidual, sumOf);
+
+            for (std::size_t slot = 0; slot != factors.size(); ++slot)
+            {
+                factors[slot] = static_cast<ScalarType>(sigmasNew[slot] / sigmas[slot]);
+            }
+
+            forEachComponentRun(scheduler, activeCells, slots, [&](const IntegerType index, const IntegerType count, const IntegerType slot) -> void
+            {
+                const IntegerType cell = activeCells.cell(index);
+
+                RunOperations::sumIn(level, searchValues + cell, 1, auxiliaryValues + cell, factors[slot], searchValues + cell, count);
+            });
+
+            sigmas = sigmasNew;
+        }
+    }
+
+    // The diagonal coefficient of the row of the active cell, the coefficients of its
+    // neighbours go to the array in the order of ActiveCellsList::Neighbour.
+
+    static inline ScalarType rowCoefficients(const CoefficientsGrid& coefficients, const ActiveCellsList& activeCells,
+        const IntegerType index, ScalarType (&neighbourCoefficients)[ActiveCellsList::neighboursCount])
+    {
+        const ScalarFourdDVector<ScalarType>* const coefficientValues = coefficients.data();
+        const ScalarFourdDVector<ScalarType>& coefficient = coefficientValues[activeCells.cell(index)];
+
+        neighbourCoefficients[ActiveCellsList::iMinusNeighbour] = coefficientValues[activeCells.neighbour(index, ActiveCellsList::iMinusNeighbour)].y;
+        neighbourCoefficients[ActiveCellsList::iPlusNeighbour] = coefficient.y;
+        neighbourCoefficients[ActiveCellsList::jMinusNeighbour] = coefficientValues[activeCells.neighbour(index, ActiveCellsList::jMinusNeighbour)].z;
+        neighbourCoefficients[ActiveCellsList::jPlusNeighbour] = coefficient.z;
+        neighbourCoefficients[ActiveCellsList::kMinusNeighbour] = coefficientValues[activeCells.neighbour(index, ActiveCellsList::kMinusNeighbour)].w;
+        neighbourCoefficients[ActiveCellsList::kPlusNeighbour] = coefficient.w;
+
+        return coefficient.x;
+    }
+
+    static inline ScalarType rowCoefficients(const PressureStencilGrid& coefficients, const ActiveCellsList& activeCells,
+        const IntegerType index, ScalarType (&neighbourCoefficients)[ActiveCellsList::neighboursCount])
+    {
+        const PressureStencil stencil = coefficients.stencils().data()[activeCells.cell(index)];
+        const ScalarType scale = static_cast<ScalarType>(coefficients.scale());
+
+        for (IntegerType neighbour = 0; neighbour < ActiveCellsList::neighboursCount; ++neighbour)
+        {
+            neighbourCoefficients[neighbour] = PressureStencilGrid::hasFluidNeighbour(stencil, static_cast<ActiveCellsList::Neighbour>(neighbour))
+                ? -scale : 0;
+        }
+
+        return scale * static_cast<ScalarType>(PressureStencilGrid::diagonal(stencil));
+    }
+
+    // One Gauss-Seidel pass over the active cells, each value moves by the relaxation factor
+    // times its step to the solution of its row, 1 is Gauss-Seidel itself. The cells of the
+    // list have to be no neighbours of each other, as the cells of one colour of a red-black
+    // ordering, so the chunks can update them in parallel. Cells without fluid neighbours
+    // and without air neighbours have no row and keep their values.
+
+    template <typename CoefficientsType>
+    static void relax(
+        TaskScheduler& scheduler,
+        ScalarsGrid& solution,
+        const ScalarsGrid& rhs,
+        const CoefficientsType& coefficients,
+        const ActiveCellsList& activeCells,
+        const ScalarType relaxation)
+    {
+        ScalarType* const solutionValues = solution.data();
+        const ScalarType* const rhsValues = rhs.data();
+
+        activeCells.parallelForChunks(scheduler, [&](const IntegerType begin, const IntegerType end) -> void
+        {
+            for (IntegerType index = begin; index < end; ++index)
+            {
+                ScalarType neighbourCoefficients[ActiveCellsList::neighboursCount];
+
+                const ScalarType diagonal = rowCoefficients(coefficients, activeCells, index, neighbourCoefficients);
+
+                if (!(diagonal > 0))
+                {
+                    continue;
+                }
+
+                const IntegerType cell = activeCells.cell(index);
+
+                ScalarType value = rhsValues[cell];
+
+                for (IntegerType neighbour = 0; neighbour < ActiveCellsList::neighboursCount; ++neighbour)
+                {
+                    value -= neighbourCoefficients[neighbour]
+                        * solutionValues[activeCells.neighbour(index, static_cast<ActiveCellsList::Neighbour>(neighbour))];
+                }
+
+                solutionValues[cell] += relaxation * (value / diagonal - solutionValues[cell]);
+            }
+        });
+    }
+
+    // Pipelined iterations of Ghysels and Vanroose with the same preconditioner. They need
+    // one reduction per iteration instead of three, it is fused with the vector updates and
+    // its results are used only after the next preconditioner and matrix applications. The
+    // vectors follow recurrences, so the residual may drift from the true one slightly more
+    // than in solve.
+
+    template <typename CoefficientsType>
+    void solvePipelined(ScalarsGrid& solution, ScalarsGrid& residual, const CoefficientsType& coefficients,
+        const ScalarsGrid& preconditioner, const ActiveCellsList& activeCells,
+        const AccumulatorType tolerance, const IntegerType maxIterations)
+    {
+        const ScalarsGridPtr factorizationSolveBuffer = checkOutZeroed(solution.res());
+
+        solvePipelinedPreconditioned(solution, residual, coefficients, activeCells,
+            [&](ScalarsGrid& target, const ScalarsGrid& source) -> void
+        {
+            applyPreconditioner(target, *factorizationSolveBuffer, coefficients, preconditioner, source);
+        }, tolerance, maxIterations);
+    }
+
+    // With u = M^-1 r and w = A u the iterations keep p, s = A p, q = M^-1 s and z = A q
+    // by recurrences and apply the preconditioner and the matrix once, to m = M^-1 w and
+    // n = A m.
+
+    template <typename CoefficientsType, typename PreconditionerType>
+    void solvePipelinedPreconditioned(ScalarsGrid& solution, ScalarsGrid& residual, const CoefficientsType& coefficients,
+        const ActiveCellsList& activeCells, PreconditionerType precondition, const AccumulatorType tolerance, const IntegerType maxIterations)
+    {
+        PipelinedVectors vectors(solution, residual);
+
+        vectors.preconditioned = checkOutZeroed(solution.res());
+        vectors.product = checkOutZeroed(solution.res());
+        vectors.preconditionedProduct = checkOutZeroed(solution.res());
+        vectors.secondProduct = checkOutZeroed(solution.res());
+        vectors.search = checkOutZeroed(solution.res());
+        vectors.searchProduct = checkOutZeroed(solution.res());
+        vectors.preconditionedSearchProduct = checkOutZeroed(solution.res());
+        vectors.searchSecondProduct = checkOutZeroed(solution.res());
+
+        TaskScheduler& scheduler = *m_scheduler;
+
+        precondition(*vectors.preconditioned, residual);
+        applyMatrix(scheduler, *vectors.product, coefficients, *vectors.preconditioned, activeCells);
+
+        PipelinedReductions reductions = reducePipelined(scheduler, vectors, activeCells);
+
+        AccumulatorType gamma = 0;
+        AccumulatorType alpha = 0;
+
+        for (IntegerType iteration = 0; iteration < maxIterations; ++iteration)
+        {
+            if (reductions.stopRate <= tolerance)
+            {
+                return;
+            }
+
+            precondition(*vectors.preconditionedProduct, *vectors.product);
+            applyMatrix(scheduler, *vectors.secondProduct, coefficients, *vectors.preconditionedProduct, activeCells);
+
+            const AccumulatorType betta = iteration == 0 ? 0 : reductions.gamma / gamma;
+
+            alpha = iteration == 0
+                ? reductions.gamma / reductions.delta
+                : reductions.gamma / (reductions.delta - betta * reductions.gamma / alpha);
+
+            gamma = reductions.gamma;
+
+            reductions = updatePipelined(scheduler, vectors, static_cast<ScalarType>(alpha), static_cast<ScalarType>(betta), activeCells);
+        }
+    }
+
+    static AccumulatorType multiply(
+        TaskScheduler& scheduler,
+        const ScalarsGrid& left,
+        const ScalarsGrid& right,
+        const ActiveCellsList& activeCells)
+    {
+        const ScalarType* const leftValues = left.data();
+        const ScalarType* const rightValues = right.data();
+        const SimdLevel level = simdLevel();
+
+        return activeCells.parallelReduceChunks(scheduler, static_cast<AccumulatorType>(0),
+            [&](const IntegerType begin, const IntegerType end) -> AccumulatorType
+        {
+            AccumulatorType result = 0;
+
+            activeCells.forEachRun(begin, end, [&](const IntegerType index, const IntegerType count) -> void
+            {
+                const IntegerType cell = activeCells.cell(index);
+
+                result = RunOperations::multiply(level, result, leftValues + cell, rightValues + cell, count);
+            });
+
+            return result;
+        }, [](const AccumulatorType left, const AccumulatorType right) -> AccumulatorType
+        {
+            return left + right;
+        });
+    }
+
+    // Dot products of the left vector with each of the right ones in one pass.
+
+    static std::vector<AccumulatorType> multiply(
+        TaskScheduler& scheduler,
+        const ScalarsGrid& left,
+        const std::vector<const ScalarsGrid*>& rights,
+        const ActiveCellsList& activeCells)
+    {
+        const ScalarType* const leftValues = left.data();
+
+        return activeCells.parallelReduceChunks(scheduler, std::vector<AccumulatorType>(rights.size(), 0),
+            [&](const IntegerType begin, const IntegerType end) -> std::vector<AccumulatorType>
+        {
+            std::vector<AccumulatorType> results(rights.size(), 0);
+
+            for (std::size_t right = 0; right != rights.size(); ++right)
+            {
+                const ScalarType* const rightValues = rights[right]->data();
+
+                AccumulatorType result = 0;
+
+                for (IntegerType index = begin; index < end; ++index)
+                {
+                    const IntegerType cell = activeCells.cell(index);
+
+                    result += static_cast<AccumulatorType>(leftValues[cell]) * static_cast<AccumulatorType>(rightValues[cell]);
+                }
+
+                results[right] = result;
+            }
+
+            return results;
+        }, [](std::vector<AccumulatorType> left, const std::vector<AccumulatorType>& right) -> std::vector<AccumulatorType>
+        {
+            for (std::size_t index = 0; index != left.size(); ++index)
+            {
+                left[index] += right[index];
+            }
+
+            return left;
+        });
+    }
+
+    template <typename CoefficientsType>
+    static void applyMatrix(
+        TaskScheduler& scheduler,
+        ScalarsGrid& target,
+        const CoefficientsType& coefficients,
+        const ScalarsGrid& source,
+        const ActiveCellsList& activeCells)
+    {
+        applyMatrixRuns(scheduler, target, coefficients, source, activeCells);
+    }
+
+    // The product and the dot product of the source with it, which gives the step of the
+    // iterations, in one pass over the active cells.
+
+    template <typename CoefficientsType>
+    static AccumulatorType applyMatrixAndMultiply(
+        TaskScheduler& scheduler,
+        ScalarsGrid& target,
+        const CoefficientsType& coefficients,
+        const ScalarsGrid& source,
+        const ActiveCellsList& activeCells)
+    {
+        return applyMatrixRuns(scheduler, target, coefficients, source, activeCells);
+    }
+
+    // Steps the solution along the search direction and the residual along the product of
+    // the matrix with it in one pass over the active cells, returns the stop rate of the
+    // new residual.
+
+    static AccumulatorType updateSolutionAndResidual(
+        TaskScheduler& scheduler,
+        ScalarsGrid& solution,
+        ScalarsGrid& residual,
+        const ScalarType step,
+        const ScalarsGrid& search,
+        const ScalarsGrid& product,
+        const ActiveCellsList& activeCells)
+    {
+        ScalarType* const solutionValues = solution.data();
+        ScalarType* const residualValues = residual.data();
+        const ScalarType* const searchValues = search.data();
+        const ScalarType* const productValues = product.data();
+        const SimdLevel level = simdLevel();
+
+        return activeCells.parallelReduceChunks(scheduler, static_cast<AccumulatorType>(0),
+            [&](const IntegerType begin, const IntegerType end) -> AccumulatorType
+        {
+            AccumulatorType maxAbsValue = 0;
+
+            activeCells.forEachRun(begin, end, [&](const IntegerType index, const IntegerType count) -> void
+            {
+                const IntegerType cell = activeCells.cell(index);
+
+                maxAbsValue = RunOperations::updateSolutionAndResidual(level, maxAbsValue, solutionValues + cell, residualValues + cell,
+                    step, searchValues + cell, productValues + cell, count);
+            });
+
+            return maxAbsValue;
+        }, [](const AccumulatorType left, const AccumulatorType right) -> AccumulatorType
+        {
+            return std::max(left, right);
+        });
+    }
+
+    static void sumIn(
+        TaskScheduler& scheduler,
+        ScalarsGrid& target,
+        const ScalarType factorLeft,
+        const ScalarsGrid& sourceLeft,
+        const ScalarType factorRight,
+        const ScalarsGrid& sourceRight,
+        const ActiveCellsList& activeCells)
+    {
+        ScalarType* const targetValues = target.data();
+        const ScalarType* const leftValues = sourceLeft.data();
+        const ScalarType* const rightValues = sourceRight.data();
+        const SimdLevel level = simdLevel();
+
+        activeCells.parallelForChunks(scheduler, [&](const IntegerType begin, const IntegerType end) -> void
+        {
+            activeCells.forEachRun(begin, end, [&](const IntegerType index, const IntegerType count) -> void
+            {
+                const IntegerType cell = activeCells.cell(index);
+
+                RunOperations::sumIn(level, targetValues + cell, factorLeft, leftValues + cell, factorRight, rightValues + cell, count);
+            });
+        });
+    }
+
+    // The sum of the two vectors and of the given multiples of the others in one pass.
+
+    static void sumIn(
+        TaskScheduler& scheduler,
+        ScalarsGrid& target,
+        const ScalarType factorLeft,
+        const ScalarsGrid& sourceLeft,
+        const ScalarType factorRight,
+        const ScalarsGrid& sourceRight,
+        const std::vector<AccumulatorType>& factors,
+        const std::vector<const ScalarsGrid*>& sources,
+        const ActiveCellsList& activeCells)
+    {
+        ScalarType* const targetValues = target.data();
+        const ScalarType* const leftValues = sourceLeft.data();
+        const ScalarType* const rightValues = sourceRight.data();
+
+        activeCells.parallelForChunks(scheduler, [&](const IntegerType begin, const IntegerType end) -> void
+        {
+            for (IntegerType index = begin; index < end; ++index)
+            {
+                const IntegerType cell = activeCells.cell(index);
+
+                ScalarType value = factorLeft * leftValues[cell] + factorRight * rightValues[cell];
+
+                for (std::size_t source = 0; source != sources.size(); ++source)
+                {
+                    value += static_cast<ScalarType>(factors[source]) * sources[source]->data()[cell];
+                }
+
+                targetValues[cell] = value;
+            }
+        });
+    }
+
+private:
+    // Numbers of the iterated components, in the order of the components, and which of them
+    // have not converged yet.
+
+    class ComponentSlots
+    {
+    public:
+        ComponentSlots(const FluidComponents& components, const IntegerType minCellsCount)
+            : m_components(components)
+            , m_slots(components.size(), -1)
+        {
+            for (IntegerType component = 0; component < components.size(); ++component)
+            {
+                if (components.cellsCount(component) > minCellsCount)
+                {
+                    m_slots[component] = static_cast<IntegerType>(m_iterated.size());
+                    m_iterated.push_back(true);
+                }
+            }
+        }
+
+        inline const FluidComponents& components() const
+        {
+            return m_components;
+        }
+
+        inline IntegerType size() const
+        {
+            return static_cast<IntegerType>(m_iterated.size());
+        }
+
+        // Slot of the component, -1 for the components which are not iterated.
+
+        inline IntegerType slot(const IntegerType component) const
+        {
+            return m_slots[component];
+        }
+
+        inline bool iterated(const IntegerType slot) const
+        {
+            return slot >= 0 && m_iterated[slot];
+        }
+
+        // Stops the components whose stop rates dropped to the tolerance, returns whether any
+        // component is left.
+
+        bool updateIterated(const std::vector<AccumulatorType>& stopRates, const AccumulatorType tolerance)
+        {
+            bool anyIterated = false;
+
+            for (std::size_t slot = 0; slot != m_iterated.size(); ++slot)
+            {
+                m_iterated[slot] = m_iterated[slot] && stopRates[slot] > tolerance;
+
+                anyIterated = anyIterated || m_iterated[slot];
+            }
+
+            return anyIterated;
+        }
+
+    private:
+        const FluidComponents& m_components;
+
+        std::vector<IntegerType> m_slots;
+        std::vector<char> m_iterated;
+    };
+
+    static AccumulatorType sumOf(const AccumulatorType left, const AccumulatorType right)
+    {
+        return left + right;
+    }
+
+    static AccumulatorType maxOf(const AccumulatorType left, const AccumulatorType right)
+    {
+        return std::max(left, right);
+    }
+
+    // Calls functor(index, count, slot) for the runs of the active cells, see forEachRun,
+    // within the components which are still iterated.
+
+    template <typename FunctorType>
+    static inline void forEachComponentRun(const ActiveCellsList& activeCells, const ComponentSlots& slots,
+        const IntegerType begin, const IntegerType end, FunctorType functor)
+    {
+        slots.components().forEachSegment(begin, end, [&](const IntegerType index, const IntegerType count, const IntegerType component) -> void
+        {
+            const IntegerType slot = slots.slot(component);
+
+            if (slots.iterated(slot))
+            {
+                activeCells.forEachRun(index, index + count, [&](const IntegerType runIndex, const IntegerType runCount) -> void
+                {
+                    functor(runIndex, runCount, slot);
+                });
+            }
+        });
+    }
+
+    template <typename FunctorType>
+    static void forEachComponentRun(TaskScheduler& scheduler, const ActiveCellsList& activeCells, const ComponentSlots& slots,
+        FunctorType functor)
+    {
+        activeCells.parallelForChunks(scheduler, [&](const IntegerType begin, const IntegerType end) -> void
+        {
+            forEachComponentRun(activeCells, slots, begin, end, functor);
+        });
+    }
+
+    // Folds map(result, index, count, slot) over the runs of each iterated component, in the
+    // order of the list, and combines the results of the chunks.
+
+    template <typename MapType, typename CombineType>
+    static std::vector<AccumulatorType> reduceComponents(TaskScheduler& scheduler, const ActiveCellsList& activeCells,
+        const ComponentSlots& slots, MapType map, CombineType combine)
+    {
+        const std::vector<AccumulatorType> identity(slots.size(), 0);
+
+        return activeCells.parallelReduceChunks(scheduler, identity,
+            [&](const IntegerType begin, const IntegerType end) -> std::vector<AccumulatorType>
+        {
+            std::vector<AccumulatorType> results(identity);
+
+            forEachComponentRun(activeCells, slots, begin, end, [&](const IntegerType index, const IntegerType count, const IntegerType slot) -> void
+            {
+                results[slot] = map(results[slot], index, count, slot);
+            });
+
+            return results;
+        }, [&](std::vector<AccumulatorType> left, const std::vector<AccumulatorType>& right) -> std::vector<AccumulatorType>
+        {
+            for (std::size_t slot = 0; slot != left.size(); ++slot)
+            {
+                left[slot] = combine(left[slot], right[slot]);
+            }
+
+            return left;
+        });
+    }
+
+    static inline IntegerType componentColumn(const IntegerType* const cells, const IntegerType cellsCount, const IntegerType index)
+    {
+        return static_cast<IntegerType>(std::lower_bound(cells, cells + cellsCount, index) - cells);
+    }
+
+    // Cholesky factorization of the dense symmetric matrix in place and the solve with it,
+    // the unknowns hold the right hand side. Returns false when a pivot vanished, then the
+    // unknowns solve the system only up to the rows of the vanished pivots.
+
+    static bool solveDense(std::vector<AccumulatorType>& matrix, std::vector<AccumulatorType>& unknowns, const IntegerType size)
+    {
+        bool regular = true;
+
+        for (IntegerType column = 0; column < size; ++column)
+        {
+            AccumulatorType pivot = matrix[column * size + column];
+            const AccumulatorType originalPivot = pivot;
+
+            for (IntegerType inner = 0; inner < column; ++inner)
+            {
+                pivot -= matrix[column * size + inner] * matrix[column * size + inner];
+            }
+
+            const bool vanishing = !(pivot > std::numeric_limits<AccumulatorType>::epsilon() * 16 * originalPivot);
+            const AccumulatorType diagonal = vanishing ? 0 : std::sqrt(pivot);
+
+            matrix[column * size + column] = diagonal;
+            regular = regular && !vanishing;
+
+            for (IntegerType row = column + 1; row < size; ++row)
+            {
+                AccumulatorType value = matrix[row * size + column];
+
+                for (IntegerType inner = 0; inner < column; ++inner)
+                {
+                    value -= matrix[row * size + inner] * matrix[column * size + inner];
+                }
+
+                matrix[row * size + column] = vanishing ? 0 : value / diagonal;
+            }
+        }
+
+        for (IntegerType row = 0; row < size; ++row)
+        {
+            AccumulatorType value = unknowns[row];
+
+            for (IntegerType inner = 0; inner < row; ++inner)
+            {
+                value -= matrix[row * size + inner] * unknowns[inner];
+            }
+
+            const AccumulatorType diagonal = matrix[row * size + row];
+            unknowns[row] = diagonal == 0 ? 0 : value / diagonal;
+        }
+
+        for (IntegerType row = size - 1; row >= 0; --row)
+        {
+            AccumulatorType value = unknowns[row];
+
+            for (IntegerType inner = row + 1; inner < size; ++inner)
+            {
+                value -= matrix[inner * size + row] * unknowns[inner];
+            }
+
+            const AccumulatorType diagonal = matrix[row * size + row];
+            unknowns[row] = diagonal == 0 ? 0 : value / diagonal;
+        }
+
+        return regular;
+    }
+
+    struct PipelinedVectors
+    {
+        PipelinedVectors(ScalarsGrid& solution, ScalarsGrid& residual)
+            : solution(solution)
+            , residual(residual)
+        {
+        }
+
+        ScalarsGrid& solution;
+        ScalarsGrid& residual;
+
+        ScalarsGridPtr preconditioned;
+        ScalarsGridPtr product;
+        ScalarsGridPtr preconditionedProduct;
+        ScalarsGridPtr secondProduct;
+        ScalarsGridPtr search;
+        ScalarsGridPtr searchProduct;
+        ScalarsGridPtr preconditionedSearchProduct;
+        ScalarsGridPtr searchSecondProduct;
+    };
+
+    // gamma = (r, u), delta = (w, u) and the stop rate of r.
+
+    struct PipelinedReductions
+    {
+        AccumulatorType gamma;
+        AccumulatorType delta;
+        AccumulatorType stopRate;
+    };
+
+    static PipelinedReductions combinePipelined(const PipelinedReductions& left, const PipelinedReductions& right)
+    {
+        PipelinedReductions result;
+
+        result.gamma = left.gamma + right.gamma;
+        result.delta = left.delta + right.delta;
+        result.stopRate = std::max(left.stopRate, right.stopRate);
+
+        return result;
+    }
+
+    static inline void accumulatePipelined(PipelinedReductions& reductions,
+        const ScalarType residualValue, const ScalarType preconditionedValue, const ScalarType productValue)
+    {
+        reductions.gamma += static_cast<AccumulatorType>(residualValue) * static_cast<AccumulatorType>(preconditionedValue);
+        reductions.delta += static_cast<AccumulatorType>(productValue) * static_cast<AccumulatorType>(preconditionedValue);
+
+        const AccumulatorType currentAbsValue = std::abs(static_cast<AccumulatorType>(residualValue));
+
+        if (currentAbsValue > reductions.stopRate)
+        {
+            reductions.stopRate = currentAbsValue;
+        }
+    }
+
+    static PipelinedReductions reducePipelined(TaskScheduler& scheduler, const PipelinedVectors& vectors, const ActiveCellsList& activeCells)
+    {
+        const ScalarType* const residualValues = vectors.residual.data();
+        const ScalarType* const preconditionedValues = vectors.preconditioned->data();
+        const ScalarType* const productValues = vectors.product->data();
+
+        const PipelinedReductions identity = { 0, 0, 0 };
+
+        return activeCells.parallelReduceChunks(scheduler, identity,
+            [&](const IntegerType begin, const IntegerType end) -> PipelinedReductions
+        {
+            PipelinedReductions reductions = identity;
+
+            for (IntegerType index = begin; index < end; ++index)
+            {
+                const IntegerType cell = activeCells.cell(index);
+
+                accumulatePipelined(reductions, residualValues[cell], preconditionedValues[cell], productValues[cell]);
+            }
+
+            return reductions;
+        }, combinePipelined);
+    }
+
+    // The recurrences of an iteration and the reductions of the next one in one pass over
+    // the active cells.
+
+    static PipelinedReductions updatePipelined(TaskScheduler& scheduler, const PipelinedVectors& vectors,
+        const ScalarType alpha, const ScalarType betta, const ActiveCellsList& activeCells)
+    {
+        ScalarType* const solutionValues = vectors.solution.data();
+        ScalarType* const residualValues = vectors.residual.data();
+        ScalarType* const preconditionedValues = vectors.preconditioned->data();
+        ScalarType* const productValues = vectors.product->data();
+        const ScalarType* const preconditionedProductValues = vectors.preconditionedProduct->data();
+        const ScalarType* const secondProductValues = vectors.secondProduct->data();
+        ScalarType* const searchValues = vectors.search->data();
+        ScalarType* const searchProductValues = vectors.searchProduct->data();
+        ScalarType* const preconditionedSearchProductValues = vectors.preconditionedSearchProduct->data();
+        ScalarType* const searchSecondProductValues = vectors.searchSecondProduct->data();
+
+        const PipelinedReductions identity = { 0, 0, 0 };
+
+        return activeCells.parallelReduceChunks(scheduler, identity,
+            [&](const IntegerType begin, const IntegerType end) -> PipelinedReductions
+        {
+            PipelinedReductions reductions = identity;
+
+            for (IntegerType index = begin; index < end; ++index)
+            {
+                const IntegerType cell = activeCells.cell(index);
+
+                const ScalarType searchSecondProduct = secondProductValues[cell] + betta * searchSecondProductValues[cell];
+                const ScalarType preconditionedSearchProduct = preconditionedProductValues[cell] + betta * preconditionedSearchProductValues[cell];
+                const ScalarType searchProduct = productValues[cell] + betta * searchProductValues[cell];
+                const ScalarType search = preconditionedValues[cell] + betta * searchValues[cell];
+
+                searchSecondProductValues[cell] = searchSecondProduct;
+                preconditionedSearchProductValues[cell] = preconditionedSearchProduct;
+                searchProductValues[cell] = searchProduct;
+                searchValues[cell] = search;
+
+                solutionValues[cell] += alpha * search;
+
+                const ScalarType residualValue = residualValues[cell] - alpha * searchProduct;
+                const ScalarType preconditionedValue = preconditionedValues[cell] - alpha * preconditionedSearchProduct;
+                const ScalarType productValue = productValues[cell] - alpha * searchSecondProduct;
+
+                residualValues[cell] = residualValue;
+                preconditionedValues[cell] = preconditionedValue;
+                productValues[cell] = productValue;
+
+                accumulatePipelined(reductions, residualValue, preconditionedValue, productValue);
+            }
+
+            return reductions;
+        }, combinePipelined);
+    }
+
+    ScalarsGridPtr checkOutZeroed(const IntegersThreeDVector& resolution)
+    {
+        const ScalarsGridPtr grid = m_arena->checkOut<ScalarsGrid>(resolution, GridHalo(1));
+
+        setValues<ScalarType>(grid, 0);
+
+        return grid;
+    }
+
+    // FNV-1a over 64 bit words, the chunks are hashed in parallel and their hashes are
+    // combined in the order of the chunks.
+
+    static const std::uint64_t fingerprintBasis = 14695981039346656037ULL;
+    static const std::uint64_t fingerprintPrime = 1099511628211ULL;
+    static const IntegerType fingerprintGrain = 16384;
+
+    static std::uint64_t fingerprint(TaskScheduler& scheduler, const void* const data, const std::size_t size)
+    {
+        const unsigned char* const bytes = static_cast<const unsigned char*>(data);
+        const IntegerType wordsCount = static_cast<IntegerType>(size / sizeof(std::uint64_t));
+        const std::uint64_t basis = fingerprintBasis;
+
+        const std::uint64_t wordsHash = scheduler.parallelReduce(0, wordsCount, fingerprintGrain, basis,
+            [&](const IntegerType begin, const IntegerType end) -> std::uint64_t
+        {
+            std::uint64_t hash = basis;
+
+            for (IntegerType index = begin; index < end; ++index)
+            {
+                std::uint64_t word;
+                std::memcpy(&word, bytes + index * sizeof(std::uint64_t), sizeof(std::uint64_t));
+
+                hash = (hash ^ word) * fingerprintPrime;
+            }
+
+            return hash;
+        }, [](const std::uint64_t left, const std::uint64_t right) -> std::uint64_t
+        {
+            return (left ^ right) * fingerprintPrime;
+        });
+
+        return fingerprint(wordsHash, bytes + wordsCount * sizeof(std::uint64_t), size % sizeof(std::uint64_t));
+    }
+
+    static std::uint64_t fingerprint(std::uint64_t hash, const void* const data, const std::size_t size)
+    {
+        const unsigned char* const bytes = static_cast<const unsigned char*>(data);
+
+        for (std::size_t index = 0; index < size; ++index)
+        {
+            hash = (hash ^ bytes[index]) * fingerprintPrime;
+        }
+
+        return hash;
+    }
+
+    template <typename CoefficientsType>
+    void applyPreconditioner(
+        ScalarsGrid& auxiliary,
+        ScalarsGrid& factorizationSolve,
+        const CoefficientsType& coefficients,
+        const ScalarsGrid& preconditioner,
+        const ScalarsGrid& residual) const
+    {
+        parallelForEachIndexWavefront(*m_scheduler, factorizationSolve, true, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            if (!m_predicate.at(i, j, k))
+            {
+                return;
+            }
+
+            const ScalarThreeDVector<ScalarType> lower = lowerCoefficients(coefficients, i, j, k);
+
+            const ScalarType ft = lower.x * preconditioner.at(i - 1, j, k) * factorizationSolve.at(i - 1, j, k);
+            const ScalarType st = lower.y * preconditioner.at(i, j - 1, k) * factorizationSolve.at(i, j - 1, k);
+            const ScalarType tt = lower.z * preconditioner.at(i, j, k - 1) * factorizationSolve.at(i, j, k - 1);
+
+            const ScalarType tValue = residual.at(i, j, k) - ft - st - tt;
+
+            factorizationSolve.at(i, j, k) = tValue * preconditioner.at(i, j, k);
+        });
+
+        parallelForEachIndexWavefront(*m_scheduler, auxiliary, false, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            if (!m_predicate.at(i, j, k))
+            {
+                return;
+            }
+
+            const ScalarFourdDVector<ScalarType>& coefficient = coefficients.at(i, j, k);
+
+            const ScalarType ft = coefficient.y * preconditioner.at(i, j, k) * auxiliary.at(i + 1, j, k);
+            const ScalarType st = coefficient.z * preconditioner.at(i, j, k) * auxiliary.at(i, j + 1, k);
+            const ScalarType tt = coefficient.w * preconditioner.at(i, j, k) * auxiliary.at(i, j, k + 1);
+
+            const ScalarType tValue = factorizationSolve.at(i, j, k) - ft - st - tt;
+
+            auxiliary.at(i, j, k) = tValue * preconditioner.at(i, j, k);
+        });
+    }
+
+    // Product of the matrix with the source over the runs of the active cells, returns the
+    // dot product of the source with it.
+
+    template <typename CoefficientsType>
+    static AccumulatorType applyMatrixRuns(
+        TaskScheduler& scheduler,
+        ScalarsGrid& target,
+        const CoefficientsType& coefficients,
+        const ScalarsGrid& source,
+        const ActiveCellsList& activeCells)
+    {
+        ScalarType* const targetValues = target.data();
+        const ScalarType* const sourceValues = source.data();
+        const SimdLevel level = simdLevel();
+
+        return activeCells.parallelReduceChunks(scheduler, static_cast<AccumulatorType>(0),
+            [&](const IntegerType begin, const IntegerType end) -> AccumulatorType
+        {
+            AccumulatorType result = 0;
+
+            activeCells.forEachRun(begin, end, [&](const IntegerType index, const IntegerType count) -> void
+            {
+                result = applyMatrixAndMultiplyRun(level, result, targetValues, coefficients, sourceValues, activeCells, index, count);
+            });
+
+            return result;
+        }, [](const AccumulatorType left, const AccumulatorType right) -> AccumulatorType
+        {
+            return left + right;
+        });
+    }
+
+    // The product over a run of the active cells and its dot product with the source, added
+    // to the result. The neighbours of a run are runs along i too, so the rows read them and
+    // the coefficients of the minus neighbours as vectors.
+
+    static inline AccumulatorType applyMatrixAndMultiplyRun(const SimdLevel level, const AccumulatorType result, ScalarType* const targetValues,
+        const CoefficientsGrid& coefficients, const ScalarType* const sourceValues, const ActiveCellsList& activeCells,
+        const IntegerType begin, const IntegerType count)
+    {
+        const ScalarFourdDVector<ScalarType>* const coefficientValues = coefficients.data();
+
+        const IntegerType cell = activeCells.cell(begin);
+
+        const ScalarType* neighbours[ActiveCellsList::neighboursCount];
+        runNeighbours(neighbours, sourceValues, activeCells, begin);
+
+        const ScalarFourdDVector<ScalarType>* const lowerCoefficients[] =
+        {
+            coefficientValues + activeCells.neighbour(begin, ActiveCellsList::iMinusNeighbour),
+            coefficientValues + activeCells.neighbour(begin, ActiveCellsList::jMinusNeighbour),
+            coefficientValues + activeCells.neighbour(begin, ActiveCellsList::kMinusNeighbour)
+        };
+
+        return RunOperations::applyCoefficients(level, result, targetValues + cell, sourceValues + cell, neighbours,
+            coefficientValues + cell, lowerCoefficients, count);
+    }
+
+    // The vectors of the iterations are zero outside of the predicate, so a row of the
+    // stencils sums all six neighbours and reads only the diagonal count of the stencil.
+    // The source has to be zero outside of the predicate.
+
+    static inline AccumulatorType applyMatrixAndMultiplyRun(const SimdLevel level, const AccumulatorType result, ScalarType* const targetValues,
+        const PressureStencilGrid& coefficients, const ScalarType* const sourceValues, const ActiveCellsList& activeCells,
+        const IntegerType begin, const IntegerType count)
+    {
+        const IntegerType cell = activeCells.cell(begin);
+
+        const ScalarType* neighbours[ActiveCellsList::neighboursCount];
+        runNeighbours(neighbours, sourceValues, activeCells, begin);
+
+        return RunOperations::applyStencils(level, result, targetValues + cell, sourceValues + cell, neighbours,
+            coefficients.stencils().data() + cell, static_cast<ScalarType>(coefficients.scale()), count);
+    }
+
+    static inline void runNeighbours(const ScalarType** const neighbours, const ScalarType* const sourceValues,
+        const ActiveCellsList& activeCells, const IntegerType begin)
+    {
+        for (IntegerType neighbour = 0; neighbour < ActiveCellsList::neighboursCount; ++neighbour)
+        {
+            neighbours[neighbour] = sourceValues + activeCells.neighbour(begin, static_cast<ActiveCellsList::Neighbour>(neighbour));
+        }
+    }
+
+    // Coefficients between the cell and its i - 1, j - 1 and k - 1 neighbours, the matrix
+    // is symmetric, so a stencil gives them without reading the neighbours.
+
+    static inline ScalarThreeDVector<ScalarType> lowerCoefficients(const CoefficientsGrid& coefficients,
+        const IntegerType i, const IntegerType j, const IntegerType k)
+    {
+        return ScalarThreeDVector<ScalarType>(coefficients.at(i - 1, j, k).y, coefficients.at(i, j - 1, k).z, coefficients.at(i, j, k - 1).w);
+    }
+
+    static inline ScalarThreeDVector<ScalarType> lowerCoefficients(const PressureStencilGrid& coefficients,
+        const IntegerType i, const IntegerType j, const IntegerType k)
+    {
+        const PressureStencil stencil = coefficients.stencils().at(i, j, k);
+        const ScalarType offDiagonal = static_cast<ScalarType>(-coefficients.scale());
+
+        return ScalarThreeDVector<ScalarType>(
+            PressureStencilGrid::hasFluidNeighbour(stencil, ActiveCellsList::iMinusNeighbour) ? offDiagonal : 0,
+            PressureStencilGrid::hasFluidNeighbour(stencil, ActiveCellsList::jMinusNeighbour) ? offDiagonal : 0,
+            PressureStencilGrid::hasFluidNeighbour(stencil, ActiveCellsList::kMinusNeighbour) ? offDiagonal : 0);
+    }
+
+private:
+    const PredicateSpaceType m_predicate;
+
+    const GridArenaPtr m_arena;
+    const TaskSchedulerPtr m_scheduler;
+};
+
+}
+
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "../GridOperations.hpp"
+#include "../ParallelGridOperations.hpp"
+#include "IPressureSolver.hpp"
+#include "MiccgZeroKernel.hpp"
+
+#include <cassert>
+#include <cstdint>
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// The part of a solve which the solvers over MiccgZeroKernel share. A warm start begins
+// from the pressure of the previous solve over the predicate, a cold one from zero, the
+// solver iterates from there in iterate() and the solution is copied into the pressure.
+//
+// The MIC(0) preconditioner is kept between the solves and calculated again only when the
+// fingerprint of the coefficients changes.
+
+template <typename PredicateSpaceType, typename CoefficientsType>
+class MiccgZeroSolverBase
+    : public IPressureSolver
+{
+public:
+    typedef std::shared_ptr<const CoefficientsType> CoefficientsConstPtr;
+
+    MiccgZeroSolverBase(
+        const FloatsGridPtr& pressure,
+        const PredicateSpaceType& predicate,
+        const CoefficientsConstPtr& coefficients,
+        const FloatsGridConstPtr& rhs,
+        const FloatType tolerance,
+        const IntegerType maxIterations,
+        const GridArenaPtr& arena = std::make_shared<GridArena>(),
+        const TaskSchedulerPtr& scheduler = std::make_shared<TaskScheduler>(1),
+        const bool warmStart = false)
+        : m_pressure(pressure)
+        , m_predicate(predicate)
+        , m_coefficients(coefficients)
+        , m_rhs(rhs)
+        , m_tolerance(tolerance)
+        , m_maxIterations(maxIterations)
+        , m_warmStart(warmStart)
+        , m_arena(arena)
+        , m_scheduler(scheduler)
+        , m_kernel(predicate, arena, scheduler)
+        , m_preconditionerFingerprint(0)
+    {
+        assert(ActiveCellsList::sharesIndices(*coefficients, pressure->res()));
+    }
+
+    MiccgZeroSolverBase(const MiccgZeroSolverBase&) = delete;
+    MiccgZeroSolverBase& operator=(const MiccgZeroSolverBase&) = delete;
+
+    virtual void solve() override
+    {
+        const ActiveCellsList activeCells(*m_scheduler, m_pressure->res(), m_predicate);
+
+        const FloatsGridPtr solution = m_arena->checkOut<FloatsGrid>(m_pressure->res(), GridHalo(1));
+        const FloatsGridPtr residual = m_arena->checkOut<FloatsGrid>(m_pressure->res(), GridHalo(1));
+
+        if (m_warmStart)
+        {
+            KernelType::startFromGuess(*m_scheduler, *solution, *residual, *m_coefficients, *m_rhs, *m_pressure, activeCells, m_predicate);
+        }
+        else
+        {
+            KernelType::startFromZero(*m_scheduler, *solution, *residual, *m_rhs, m_predicate);
+        }
+
+        iterate(*solution, *residual, activeCells);
+
+        FloatsGrid& pressure = *m_pressure;
+        const FloatsGrid& result = *solution;
+
+        parallelForEachIndex(*m_scheduler, pressure, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            pressure.at(i, j, k) = result.at(i, j, k);
+        });
+    }
+
+protected:
+    typedef MiccgZeroKernel<FloatType, FloatType, PredicateSpaceType> KernelType;
+
+    // Iterates from the start over the active cells, the residual is the one of the solution.
+
+    virtual void iterate(FloatsGrid& solution, FloatsGrid& residual, const ActiveCellsList& activeCells) = 0;
+
+    bool meetsTolerance(const FloatsGrid& residual, const ActiveCellsList& activeCells) const
+    {
+        return KernelType::calculateStopRate(*m_scheduler, residual, activeCells) <= m_tolerance;
+    }
+
+    const FloatsGrid& preconditioner()
+    {
+        const std::uint64_t fingerprint = KernelType::calculateFingerprint(*m_scheduler, *m_coefficients);
+
+        if (!m_preconditioner || fingerprint != m_preconditionerFingerprint)
+        {
+            m_preconditioner.reset();
+            m_preconditioner = m_kernel.calculatePreconditioner(*m_coefficients);
+            m_preconditionerFingerprint = fingerprint;
+        }
+
+        return *m_preconditioner;
+    }
+
+protected:
+    const FloatsGridPtr m_pressure;
+
+    const PredicateSpaceType m_predicate;
+
+    const CoefficientsConstPtr m_coefficients;
+    const FloatsGridConstPtr m_rhs;
+
+    const FloatType m_tolerance;
+    const IntegerType m_maxIterations;
+    const bool m_warmStart;
+
+    const GridArenaPtr m_arena;
+    const TaskSchedulerPtr m_scheduler;
+
+    KernelType m_kernel;
+
+private:
+    FloatsGridPtr m_preconditioner;
+    std::uint64_t m_preconditionerFingerprint;
+};
+
+}
+
+}
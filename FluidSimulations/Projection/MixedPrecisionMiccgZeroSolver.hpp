@@ -0,0 +1,154 @@
+#pragma once
+
+#include "MiccgZeroSolverBase.hpp"
+
+#include <algorithm>
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// MIC(0) preconditioned conjugate gradient which keeps vectors, coefficients and the
+// preconditioner in float and accumulates dot products and the stop rate in double.
+// Each refinement recalculates the residual of the accumulated solution in FloatType
+// and solves for its correction in float again, so the tolerance can be reached
+// beyond the float precision. The start and the warm start are the ones of
+// MiccgZeroSolverBase.
+//
+// The coefficients are a FloatsFourDVectorGrid or a PressureStencilGrid, the float
+// iterations run over a FloatsFourDVectorGrid converted from their at() in either case,
+// the residuals in FloatType use the coefficients as they are.
+
+template <typename PredicateSpaceType, typename CoefficientsType = FloatsFourDVectorGrid>
+class MixedPrecisionMiccgZeroSolver
+    : public MiccgZeroSolverBase<PredicateSpaceType, CoefficientsType>
+{
+public:
+    typedef MiccgZeroSolverBase<PredicateSpaceType, CoefficientsType> BaseType;
+    typedef typename BaseType::CoefficientsConstPtr CoefficientsConstPtr;
+
+    static const IntegerType defaultRefinementsCount = 2;
+
+    MixedPrecisionMiccgZeroSolver(
+        const FloatsGridPtr& pressure,
+        const PredicateSpaceType& predicate,
+        const CoefficientsConstPtr& coefficients,
+        const FloatsGridConstPtr& rhs,
+        const FloatType tolerance,
+        const IntegerType maxIterations,
+        const GridArenaPtr& arena = std::make_shared<GridArena>(),
+        const TaskSchedulerPtr& scheduler = std::make_shared<TaskScheduler>(1),
+        const bool warmStart = false,
+        const IntegerType refinementsCount = defaultRefinementsCount)
+        : BaseType(pressure, predicate, coefficients, rhs, tolerance, maxIterations, arena, scheduler, warmStart)
+        , m_refinementsCount(refinementsCount)
+        , m_singleKernel(predicate, arena, scheduler)
+    {
+    }
+
+private:
+    typedef ScalarFourdDVector<float> SingleFourDVector;
+    typedef Grid<SingleFourDVector> SingleCoefficientsGrid;
+    typedef Grid<float> SinglesGrid;
+
+    typedef MiccgZeroKernel<float, double, PredicateSpaceType> SingleKernelType;
+    typedef MiccgZeroKernel<FloatType, double, PredicateSpaceType> PreciseKernelType;
+
+    virtual void iterate(FloatsGrid& solution, FloatsGrid& residual, const ActiveCellsList& activeCells) override
+    {
+        constexpr double refinementReduction = 1e-3;
+
+        TaskScheduler& scheduler = *this->m_scheduler;
+
+        const IntegersThreeDVector resolution = this->m_pressure->res();
+
+        const std::shared_ptr<SingleCoefficientsGrid> singleCoefficients =
+            this->m_arena->template checkOut<SingleCoefficientsGrid>(resolution, GridHalo(1));
+        const std::shared_ptr<SinglesGrid> singleCorrection = this->m_arena->template checkOut<SinglesGrid>(resolution, GridHalo(1));
+        const std::shared_ptr<SinglesGrid> singleResidual = this->m_arena->template checkOut<SinglesGrid>(resolution, GridHalo(1));
+
+        std::shared_ptr<SinglesGrid> preconditioner;
+
+        for (IntegerType refinement = 0; refinement <= m_refinementsCount; ++refinement)
+        {
+            const double stopRate = PreciseKernelType::calculateStopRate(scheduler, residual, activeCells);
+
+            if (stopRate <= static_cast<double>(this->m_tolerance))
+            {
+                break;
+            }
+
+            if (!preconditioner)
+            {
+                setValues(singleCoefficients, SingleFourDVector());
+                convertCoefficients(*singleCoefficients);
+
+                preconditioner = m_singleKernel.calculatePreconditioner(*singleCoefficients);
+            }
+
+            const double correctionTolerance = refinement < m_refinementsCount
+                ? std::max(static_cast<double>(this->m_tolerance), stopRate * refinementReduction)
+                : static_cast<double>(this->m_tolerance);
+
+            convertResidual(*singleResidual, residual);
+
+            setValues(singleCorrection, 0.0f);
+
+            m_singleKernel.solve(*singleCorrection, *singleResidual, *singleCoefficients, *preconditioner, activeCells,
+                correctionTolerance, this->m_maxIterations);
+
+            applyCorrection(solution, *singleCorrection);
+
+            if (refinement < m_refinementsCount)
+            {
+                PreciseKernelType::calculateResidual(scheduler, residual, *this->m_coefficients, solution, *this->m_rhs,
+                    activeCells, this->m_predicate);
+            }
+        }
+    }
+
+    void convertCoefficients(SingleCoefficientsGrid& singleCoefficients)
+    {
+        const CoefficientsType& coefficients = *this->m_coefficients;
+
+        parallelForEachIndex(*this->m_scheduler, singleCoefficients, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            const FloatsFourDVector coefficient = coefficients.at(i, j, k);
+
+            singleCoefficients.at(i, j, k) = SingleFourDVector(static_cast<float>(coefficient.x),
+                static_cast<float>(coefficient.y), static_cast<float>(coefficient.z), static_cast<float>(coefficient.w));
+        });
+    }
+
+    void convertResidual(SinglesGrid& singleResidual, const FloatsGrid& residual)
+    {
+        parallelForEachIndex(*this->m_scheduler, singleResidual, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            singleResidual.at(i, j, k) = static_cast<float>(residual.at(i, j, k));
+        });
+    }
+
+    void applyCorrection(FloatsGrid& solution, const SinglesGrid& singleCorrection)
+    {
+        const PredicateSpaceType& predicate = this->m_predicate;
+
+        parallelForEachIndex(*this->m_scheduler, solution, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            if (predicate.at(i, j, k))
+            {
+                solution.at(i, j, k) += singleCorrection.at(i, j, k);
+            }
+        });
+    }
+
+private:
+    const IntegerType m_refinementsCount;
+
+    SingleKernelType m_singleKernel;
+};
+
+}
+
+}
@@ -0,0 +1,424 @@
+#pragma once
+
+#include "../CellFlags.hpp"
+#include "../GridArena.hpp"
+#include "../GridOperations.hpp"
+#include "../ParallelGridOperations.hpp"
+#include "../TaskScheduler.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// Geometric multigrid V-cycle which preconditions conjugate gradients.
+//
+// The finest level is the operator of the coefficients over the fluid cells of the
+// classification. A coarse cell is air if one of its eight children is air, fluid if
+// one of them is fluid and solid otherwise. Coarse levels discretize the 7-point
+// Laplacian of their own classification: fluid neighbours are coupled, air neighbours
+// only add to the diagonal. Their scale is the mean scale of the finest coefficients
+// divided by four per level, as the cell size doubles.
+//
+// Residuals are restricted by the transposed trilinear interpolation divided by eight
+// and the smoother is red-black Gauss-Seidel, red before black on the way down and black
+// before red on the way up, so a cycle is the symmetric operator conjugate gradients need.
+
+class MultigridPreconditioner
+{
+public:
+    MultigridPreconditioner(
+        const CellFlagsGridConstPtr& cellFlags,
+        const FloatsFourDVectorGridConstPtr& coefficients,
+        const GridArenaPtr& arena,
+        const TaskSchedulerPtr& scheduler,
+        const IntegerType smoothingsCount = 2,
+        const IntegerType coarsestSmoothingsCount = 16)
+        : m_cellFlags(cellFlags)
+        , m_coefficients(coefficients)
+        , m_arena(arena)
+        , m_scheduler(scheduler)
+        , m_smoothingsCount(smoothingsCount)
+        , m_coarsestSmoothingsCount(coarsestSmoothingsCount)
+    {
+    }
+
+    MultigridPreconditioner(const MultigridPreconditioner&) = delete;
+    MultigridPreconditioner& operator=(const MultigridPreconditioner&) = delete;
+
+    // Coarsens the current classification, the levels stay checked out of the arena
+    // until release.
+
+    void prepare()
+    {
+        constexpr IntegerType coarsestResolution = 4;
+
+        m_levels.clear();
+        m_levels.push_back(Level(m_cellFlags, calculateFinestScale()));
+
+        for (;;)
+        {
+            const IntegersThreeDVector fineRes = m_levels.back().cellFlags->res();
+
+            if (std::min(fineRes.x, std::min(fineRes.y, fineRes.z)) <= coarsestResolution)
+            {
+                break;
+            }
+
+            const IntegersThreeDVector coarseRes((fineRes.x + 1) / 2, (fineRes.y + 1) / 2, (fineRes.z + 1) / 2);
+
+            m_levels.back().residual = m_arena->checkOut<FloatsGrid>(fineRes, GridHalo(2));
+            setValues<FloatType>(m_levels.back().residual, 0);
+
+            Level coarse(coarsen(*m_levels.back().cellFlags, coarseRes), m_levels.back().scale / 4);
+
+            coarse.solution = m_arena->checkOut<FloatsGrid>(coarseRes, GridHalo(1));
+            coarse.rhs = m_arena->checkOut<FloatsGrid>(coarseRes);
+
+            m_levels.push_back(coarse);
+        }
+    }
+
+    void release()
+    {
+        m_levels.clear();
+    }
+
+    // One cycle from the zero guess, the target has to have a halo one cell wide.
+
+    void apply(FloatsGrid& target, const FloatsGrid& source)
+    {
+        std::fill(target.data(), target.data() + target.storageSize(), static_cast<FloatType>(0));
+
+        cycle(0, target, source);
+    }
+
+private:
+    struct Level
+    {
+        Level(const CellFlagsGridConstPtr& levelCellFlags, const FloatType levelScale)
+            : cellFlags(levelCellFlags)
+            , scale(levelScale)
+        {}
+
+        CellFlagsGridConstPtr cellFlags;
+        FloatType scale;
+
+        FloatsGridPtr solution;
+        FloatsGridPtr rhs;
+        FloatsGridPtr residual;
+    };
+
+    // The off-diagonal part reads every neighbour, as the solutions are zero outside
+    // of the fluid cells.
+
+    class CoefficientsStencil
+    {
+    public:
+        CoefficientsStencil(const FloatsFourDVectorGrid& coefficients)
+            : m_coefficients(coefficients)
+        {}
+
+        inline FloatType diagonal(const IntegerType i, const IntegerType j, const IntegerType k) const
+        {
+            return m_coefficients.at(i, j, k).x;
+        }
+
+        inline FloatType offDiagonal(const FloatsGrid& source, const IntegerType i, const IntegerType j, const IntegerType k) const
+        {
+            const FloatsFourDVector& coefficient = m_coefficients.at(i, j, k);
+
+            return source.at(i + 1, j, k) * coefficient.y + source.at(i, j + 1, k) * coefficient.z + source.at(i, j, k + 1) * coefficient.w
+                + source.at(i - 1, j, k) * m_coefficients.at(i - 1, j, k).y
+                + source.at(i, j - 1, k) * m_coefficients.at(i, j - 1, k).z
+                + source.at(i, j, k - 1) * m_coefficients.at(i, j, k - 1).w;
+        }
+
+    private:
+        const FloatsFourDVectorGrid& m_coefficients;
+    };
+
+    class ClassificationStencil
+    {
+    public:
+        ClassificationStencil(const CellFlagsGrid& cellFlags, const FloatType scale)
+            : m_cellFlags(cellFlags)
+            , m_scale(scale)
+        {}
+
+        inline FloatType diagonal(const IntegerType i, const IntegerType j, const IntegerType k) const
+        {
+            const IntegerType openFaces = isOpen(i - 1, j, k) + isOpen(i + 1, j, k)
+                + isOpen(i, j - 1, k) + isOpen(i, j + 1, k) + isOpen(i, j, k - 1) + isOpen(i, j, k + 1);
+
+            return m_scale * openFaces;
+        }
+
+        inline FloatType offDiagonal(const FloatsGrid& source, const IntegerType i, const IntegerType j, const IntegerType k) const
+        {
+            return -m_scale * (source.at(i - 1, j, k) + source.at(i + 1, j, k)
+                + source.at(i, j - 1, k) + source.at(i, j + 1, k) + source.at(i, j, k - 1) + source.at(i, j, k + 1));
+        }
+
+    private:
+        inline IntegerType isOpen(const IntegerType i, const IntegerType j, const IntegerType k) const
+        {
+            return (m_cellFlags.at(i, j, k) & solidCellFlag) == 0 ? 1 : 0;
+        }
+
+    private:
+        const CellFlagsGrid& m_cellFlags;
+        const FloatType m_scale;
+    };
+
+    static inline bool isFluid(const CellFlagsGrid& cellFlags, const IntegerType i, const IntegerType j, const IntegerType k)
+    {
+        return (cellFlags.at(i, j, k) & fluidCellFlag) != 0;
+    }
+
+    FloatType calculateFinestScale() const
+    {
+        const CellFlagsGrid& cellFlags = *m_cellFlags;
+        const FloatsFourDVectorGrid& coefficients = *m_coefficients;
+
+        const ClassificationStencil unitStencil(cellFlags, 1);
+
+        typedef std::pair<FloatType, FloatType> Sums;
+
+        const Sums sums = parallelReduceIndex(*m_scheduler, cellFlags, Sums(0, 0),
+            [&](Sums& result, const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            if (isFluid(cellFlags, i, j, k))
+            {
+                result.first += coefficients.at(i, j, k).x;
+                result.second += unitStencil.diagonal(i, j, k);
+            }
+        }, [](const Sums& left, const Sums& right) -> Sums
+        {
+            return Sums(left.first + right.first, left.second + right.second);
+        });
+
+        return sums.second > 0 ? sums.first / sums.second : 0;
+    }
+
+    CellFlagsGridConstPtr coarsen(const CellFlagsGrid& fineFlags, const IntegersThreeDVector& coarseRes)
+    {
+        const CellFlagsGridPtr coarseFlagsBuffer = m_arena->checkOut<CellFlagsGrid>(coarseRes, GridHalo(1));
+        CellFlagsGrid& coarseFlags = *coarseFlagsBuffer;
+
+        setValues(coarseFlagsBuffer, solidCellFlag);
+
+        parallelForEachIndex(*m_scheduler, coarseFlags, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            bool hasAir = false;
+            bool hasFluid = false;
+
+            for (IntegerType child = 0; child != 8; ++child)
+            {
+                const CellFlags flags = fineFlags.at(2 * i + (child & 1), 2 * j + ((child >> 1) & 1), 2 * k + (child >> 2));
+
+                hasAir = hasAir || (flags & (fluidCellFlag | solidCellFlag)) == 0;
+                hasFluid = hasFluid || (flags & fluidCellFlag) != 0;
+            }
+
+            coarseFlags.at(i, j, k) = hasAir ? 0 : (hasFluid ? fluidCellFlag : solidCellFlag);
+        });
+
+        return coarseFlagsBuffer;
+    }
+
+    void cycle(const std::size_t level, FloatsGrid& solution, const FloatsGrid& rhs)
+    {
+        if (level + 1 == m_levels.size())
+        {
+            smooth(level, solution, rhs, m_coarsestSmoothingsCount, true);
+            smooth(level, solution, rhs, m_coarsestSmoothingsCount, false);
+
+            return;
+        }
+
+        Level& coarse = m_levels[level + 1];
+        FloatsGrid& residual = *m_levels[level].residual;
+
+        smooth(level, solution, rhs, m_smoothingsCount, true);
+
+        if (level == 0)
+        {
+            calculateResidual(CoefficientsStencil(*m_coefficients), *m_levels[level].cellFlags, solution, rhs, residual);
+        }
+        else
+        {
+            calculateResidual(ClassificationStencil(*m_levels[level].cellFlags, m_levels[level].scale),
+                *m_levels[level].cellFlags, solution, rhs, residual);
+        }
+
+        restrictResidual(residual, *coarse.cellFlags, *coarse.rhs);
+
+        setValues<FloatType>(coarse.solution, 0);
+
+        cycle(level + 1, *coarse.solution, *coarse.rhs);
+
+        prolongateCorrection(*coarse.solution, *m_levels[level].cellFlags, solution);
+
+        smooth(level, solution, rhs, m_smoothingsCount, false);
+    }
+
+    void smooth(const std::size_t level, FloatsGrid& solution, const FloatsGrid& rhs,
+        const IntegerType smoothingsCount, const bool redFirst)
+    {
+        const CellFlagsGrid& cellFlags = *m_levels[level].cellFlags;
+
+        for (IntegerType smoothing = 0; smoothing < smoothingsCount; ++smoothing)
+        {
+            for (IntegerType color = 0; color != 2; ++color)
+            {
+                const IntegerType parity = redFirst ? color : 1 - color;
+
+                if (level == 0)
+                {
+                    smoothColor(CoefficientsStencil(*m_coefficients), cellFlags, solution, rhs, parity);
+                }
+                else
+                {
+                    smoothColor(ClassificationStencil(cellFlags, m_levels[level].scale), cellFlags, solution, rhs, parity);
+                }
+            }
+        }
+    }
+
+    // Cells of one parity of i + j + k only read the cells of the other one.
+
+    template <typename StencilType>
+    void smoothColor(const StencilType& stencil, const CellFlagsGrid& cellFlags, FloatsGrid& solution, const FloatsGrid& rhs,
+        const IntegerType parity)
+    {
+        m_scheduler->parallelFor(0, solution.iRes(), 1, [&](const IntegerType iBegin, const IntegerType iEnd) -> void
+        {
+            for (IntegerType i = iBegin; i < iEnd; ++i)
+            {
+                for (IntegerType j = 0; j < solution.jRes(); ++j)
+                {
+                    for (IntegerType k = (i + j + parity) & 1; k < solution.kRes(); k += 2)
+                    {
+                        if (!isFluid(cellFlags, i, j, k))
+                        {
+                            continue;
+                        }
+
+                        const FloatType diagonal = stencil.diagonal(i, j, k);
+
+                        if (diagonal > 0)
+                        {
+                            solution.at(i, j, k) = (rhs.at(i, j, k) - stencil.offDiagonal(solution, i, j, k)) / diagonal;
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    template <typename StencilType>
+    void calculateResidual(const StencilType& stencil, const CellFlagsGrid& cellFlags, const FloatsGrid& solution,
+        const FloatsGrid& rhs, FloatsGrid& residual)
+    {
+        parallelForEachIndex(*m_scheduler, residual, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            residual.at(i, j, k) = isFluid(cellFlags, i, j, k)
+                ? rhs.at(i, j, k) - stencil.diagonal(i, j, k) * solution.at(i, j, k) - stencil.offDiagonal(solution, i, j, k)
+                : 0;
+        });
+    }
+
+    // Every fine cell lies a quarter of the coarse cell size from the center of its parent,
+    // it takes 3/4 of the parent and 1/4 of the next coarse cell on its side along an axis.
+
+    static inline IntegerType coarseNeighbour(const IntegerType fineIndex)
+    {
+        return (fineIndex & 1) != 0 ? fineIndex / 2 + 1 : fineIndex / 2 - 1;
+    }
+
+    void restrictResidual(const FloatsGrid& residual, const CellFlagsGrid& coarseFlags, FloatsGrid& coarseRhs)
+    {
+        static const FloatType weights[4] = { 0.25f, 0.75f, 0.75f, 0.25f };
+
+        parallelForEachIndex(*m_scheduler, coarseRhs, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            if (!isFluid(coarseFlags, i, j, k))
+            {
+                coarseRhs.at(i, j, k) = 0;
+                return;
+            }
+
+            FloatType value = 0;
+
+            for (IntegerType iStep = 0; iStep != 4; ++iStep)
+            {
+                for (IntegerType jStep = 0; jStep != 4; ++jStep)
+                {
+                    const FloatType ijWeight = weights[iStep] * weights[jStep];
+
+                    for (IntegerType kStep = 0; kStep != 4; ++kStep)
+                    {
+                        value += ijWeight * weights[kStep] * residual.at(2 * i - 1 + iStep, 2 * j - 1 + jStep, 2 * k - 1 + kStep);
+                    }
+                }
+            }
+
+            coarseRhs.at(i, j, k) = value / 8;
+        });
+    }
+
+    void prolongateCorrection(const FloatsGrid& coarseSolution, const CellFlagsGrid& fineFlags, FloatsGrid& solution)
+    {
+        parallelForEachIndex(*m_scheduler, solution, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            if (!isFluid(fineFlags, i, j, k))
+            {
+                return;
+            }
+
+            const IntegerType iIndices[2] = { i / 2, coarseNeighbour(i) };
+            const IntegerType jIndices[2] = { j / 2, coarseNeighbour(j) };
+            const IntegerType kIndices[2] = { k / 2, coarseNeighbour(k) };
+
+            static const FloatType weights[2] = { 0.75f, 0.25f };
+
+            FloatType value = 0;
+
+            for (IntegerType iStep = 0; iStep != 2; ++iStep)
+            {
+                for (IntegerType jStep = 0; jStep != 2; ++jStep)
+                {
+                    for (IntegerType kStep = 0; kStep != 2; ++kStep)
+                    {
+                        value += weights[iStep] * weights[jStep] * weights[kStep]
+                            * coarseSolution.at(iIndices[iStep], jIndices[jStep], kIndices[kStep]);
+                    }
+                }
+            }
+
+            solution.at(i, j, k) += value;
+        });
+    }
+
+private:
+    const CellFlagsGridConstPtr m_cellFlags;
+    const FloatsFourDVectorGridConstPtr m_coefficients;
+
+    const GridArenaPtr m_arena;
+    const TaskSchedulerPtr m_scheduler;
+
+    const IntegerType m_smoothingsCount;
+    const IntegerType m_coarsestSmoothingsCount;
+
+    std::vector<Level> m_levels;
+};
+
+}
+
+}
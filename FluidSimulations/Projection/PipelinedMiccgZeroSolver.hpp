@@ -0,0 +1,36 @@
+#pragma once
+
+#include "MiccgZeroSolverBase.hpp"
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// MIC(0) preconditioned pipelined conjugate gradients, see MiccgZeroKernel::solvePipelined.
+// An iteration synchronizes the threads on one reduction instead of three, which pays off
+// at high threads counts, and takes a few more vector updates. Otherwise the solver works
+// as MiccgZeroSolver: warm start, coefficients and preconditioner reuse are the same.
+
+template <typename PredicateSpaceType, typename CoefficientsType = FloatsFourDVectorGrid>
+class PipelinedMiccgZeroSolver
+    : public MiccgZeroSolverBase<PredicateSpaceType, CoefficientsType>
+{
+public:
+    using MiccgZeroSolverBase<PredicateSpaceType, CoefficientsType>::MiccgZeroSolverBase;
+
+private:
+    virtual void iterate(FloatsGrid& solution, FloatsGrid& residual, const ActiveCellsList& activeCells) override
+    {
+        if (!this->meetsTolerance(residual, activeCells))
+        {
+            this->m_kernel.solvePipelined(solution, residual, *this->m_coefficients, this->preconditioner(), activeCells,
+                this->m_tolerance, this->m_maxIterations);
+        }
+    }
+};
+
+}
+
+}
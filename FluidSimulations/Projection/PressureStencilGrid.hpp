@@ -0,0 +1,116 @@
+#pragma once
+
+#include "../GridDefinitions.hpp"
+#include "ActiveCellsList.hpp"
+
+#include <cstdint>
+#include <memory>
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// Compact form of the pressure matrix. A cell stores a bit for each of its face neighbours
+// which is fluid, the bit of a neighbour is 1 << ActiveCellsList::Neighbour, and the count
+// of its fluid and air neighbours from diagonalShift on. The entries of the matrix are the
+// count on the diagonal and -1 for the fluid neighbours, times the scale.
+//
+// The stencils grid has a halo one cell wide, so it shares the indices of ActiveCellsList,
+// and at() gives the coefficients GridAllignedPressureSolvePreparator would have written.
+
+typedef std::uint16_t PressureStencil;
+
+typedef Grid<PressureStencil> PressureStencilsGrid;
+
+class PressureStencilGrid
+{
+public:
+    static const IntegerType diagonalShift = 8;
+
+    PressureStencilGrid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes)
+        : m_stencils(iRes, jRes, kRes, GridHalo(1))
+        , m_scale(0)
+    {}
+
+    PressureStencilGrid(const PressureStencilGrid&) = delete;
+    PressureStencilGrid& operator=(const PressureStencilGrid&) = delete;
+
+    inline const IntegerType& iRes() const
+    {
+        return m_stencils.iRes();
+    }
+
+    inline const IntegerType& jRes() const
+    {
+        return m_stencils.jRes();
+    }
+
+    inline const IntegerType& kRes() const
+    {
+        return m_stencils.kRes();
+    }
+
+    inline IntegersThreeDVector res() const
+    {
+        return m_stencils.res();
+    }
+
+    inline const IntegerType& halo() const
+    {
+        return m_stencils.halo();
+    }
+
+    inline PressureStencilsGrid& stencils()
+    {
+        return m_stencils;
+    }
+
+    inline const PressureStencilsGrid& stencils() const
+    {
+        return m_stencils;
+    }
+
+    inline FloatType scale() const
+    {
+        return m_scale;
+    }
+
+    inline void setScale(const FloatType scale)
+    {
+        m_scale = scale;
+    }
+
+    static inline bool hasFluidNeighbour(const PressureStencil stencil, const ActiveCellsList::Neighbour neighbour)
+    {
+        return (stencil >> neighbour & 1) != 0;
+    }
+
+    static inline IntegerType diagonal(const PressureStencil stencil)
+    {
+        return stencil >> diagonalShift;
+    }
+
+    inline FloatsFourDVector at(const IntegerType i, const IntegerType j, const IntegerType k) const
+    {
+        const PressureStencil stencil = m_stencils.at(i, j, k);
+
+        return FloatsFourDVector(
+            m_scale * diagonal(stencil),
+            hasFluidNeighbour(stencil, ActiveCellsList::iPlusNeighbour) ? -m_scale : 0,
+            hasFluidNeighbour(stencil, ActiveCellsList::jPlusNeighbour) ? -m_scale : 0,
+            hasFluidNeighbour(stencil, ActiveCellsList::kPlusNeighbour) ? -m_scale : 0);
+    }
+
+private:
+    PressureStencilsGrid m_stencils;
+    FloatType m_scale;
+};
+
+typedef std::shared_ptr<PressureStencilGrid> PressureStencilGridPtr;
+typedef std::shared_ptr<const PressureStencilGrid> PressureStencilGridConstPtr;
+
+}
+
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "../Machinery/StepTimeBudget.hpp"
+#include "MiccgZeroSolverBase.hpp"
+
+#include <algorithm>
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// Red-black Gauss-Seidel sweeps for previews, see MiccgZeroKernel::relax. A sweep relaxes
+// the cells with even i + j + k and then the odd ones, the cells of a colour do not depend
+// on each other, so each half sweep runs in parallel. The solver stops at the tolerance,
+// at the max sweeps count or when the interval of the budget expires, after one sweep at
+// least, and reports the divergence it leaves, which is the max abs of the residual, to the
+// budget. The relaxation factor over-relaxes the sweeps above 1, below 2. The start and
+// the warm start are the ones of MiccgZeroSolverBase.
+
+template <typename PredicateSpaceType, typename CoefficientsType = FloatsFourDVectorGrid>
+class RedBlackGaussSeidelSolver
+    : public MiccgZeroSolverBase<PredicateSpaceType, CoefficientsType>
+{
+public:
+    typedef MiccgZeroSolverBase<PredicateSpaceType, CoefficientsType> BaseType;
+    typedef typename BaseType::CoefficientsConstPtr CoefficientsConstPtr;
+
+    RedBlackGaussSeidelSolver(
+        const FloatsGridPtr& pressure,
+        const PredicateSpaceType& predicate,
+        const CoefficientsConstPtr& coefficients,
+        const FloatsGridConstPtr& rhs,
+        const FloatType tolerance,
+        const IntegerType maxSweepsCount,
+        const GridArenaPtr& arena = std::make_shared<GridArena>(),
+        const TaskSchedulerPtr& scheduler = std::make_shared<TaskScheduler>(1),
+        const bool warmStart = false,
+        const Machinery::StepTimeBudgetPtr& budget = Machinery::StepTimeBudgetPtr(),
+        const FloatType relaxation = 1)
+        : BaseType(pressure, predicate, coefficients, rhs, tolerance, maxSweepsCount, arena, scheduler, warmStart)
+        , m_budget(budget)
+        , m_relaxation(relaxation)
+        , m_divergence(0)
+        , m_sweepsCount(0)
+    {
+    }
+
+    // The divergence and the sweeps count of the last solve.
+
+    inline FloatType divergence() const
+    {
+        return m_divergence;
+    }
+
+    inline IntegerType sweepsCount() const
+    {
+        return m_sweepsCount;
+    }
+
+private:
+    typedef typename BaseType::KernelType KernelType;
+
+    virtual void iterate(FloatsGrid& solution, FloatsGrid& residual, const ActiveCellsList& activeCells) override
+    {
+        TaskScheduler& scheduler = *this->m_scheduler;
+
+        const IntegersThreeDVector res = this->m_pressure->res();
+
+        const ActiveCellsList redCells(scheduler, res, ColourPredicate(this->m_predicate, 0));
+        const ActiveCellsList blackCells(scheduler, res, ColourPredicate(this->m_predicate, 1));
+
+        const FloatsGridPtr correction = this->m_arena->template checkOut<FloatsGrid>(res, GridHalo(1));
+        const FloatsGridPtr correctionResidual = this->m_arena->template checkOut<FloatsGrid>(res, GridHalo(1));
+
+        // The sweeps solve for the correction of the start, whose rhs is its residual.
+
+        std::fill(correction->data(), correction->data() + correction->storageSize(), static_cast<FloatType>(0));
+
+        const auto calculateStopRate = [&]() -> FloatType
+        {
+            KernelType::calculateResidual(scheduler, *correctionResidual, *this->m_coefficients, *correction, residual,
+                activeCells, this->m_predicate);
+
+            return KernelType::calculateStopRate(scheduler, *correctionResidual, activeCells);
+        };
+
+        FloatType stopRate = KernelType::calculateStopRate(scheduler, residual, activeCells);
+        IntegerType sweepsCount = 0;
+
+        while (stopRate > this->m_tolerance && sweepsCount < this->m_maxIterations
+            && !(sweepsCount > 0 && m_budget && m_budget->expired()))
+        {
+            KernelType::relax(scheduler, *correction, residual, *this->m_coefficients, redCells, m_relaxation);
+            KernelType::relax(scheduler, *correction, residual, *this->m_coefficients, blackCells, m_relaxation);
+
+            ++sweepsCount;
+
+            if (sweepsCount % stopCheckInterval == 0)
+            {
+                stopRate = calculateStopRate();
+            }
+        }
+
+        if (sweepsCount % stopCheckInterval != 0)
+        {
+            stopRate = calculateStopRate();
+        }
+
+        m_divergence = stopRate;
+        m_sweepsCount = sweepsCount;
+
+        if (m_budget)
+        {
+            m_budget->reportDivergence(stopRate);
+        }
+
+        const FloatsGrid& resultCorrection = *correction;
+
+        parallelForEachIndex(scheduler, solution, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+        {
+            solution.at(i, j, k) += resultCorrection.at(i, j, k);
+        });
+    }
+
+    // The residual costs about as much as a sweep, so it is checked every few sweeps only.
+
+    static const IntegerType stopCheckInterval = 4;
+
+    class ColourPredicate
+    {
+    public:
+        ColourPredicate(const PredicateSpaceType& predicate, const IntegerType colour)
+            : m_predicate(predicate)
+            , m_colour(colour)
+        {
+        }
+
+        inline bool at(const IntegerType i, const IntegerType j, const IntegerType k) const
+        {
+            return ((i + j + k) & 1) == m_colour && m_predicate.at(i, j, k);
+        }
+
+    private:
+        const PredicateSpaceType& m_predicate;
+        const IntegerType m_colour;
+    };
+
+private:
+    const Machinery::StepTimeBudgetPtr m_budget;
+    const FloatType m_relaxation;
+
+    FloatType m_divergence;
+    IntegerType m_sweepsCount;
+};
+
+}
+
+}
@@ -0,0 +1,584 @@
+#pragma once
+
+#include "../GridDefinitions.hpp"
+#include "../SimdLevel.hpp"
+#include "ActiveCellsList.hpp"
+#include "PressureStencilGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(FLUID_SIMULATIONS_X86_SIMD)
+#include <immintrin.h>
+#endif
+
+namespace FluidSimulations
+{
+
+namespace Projection
+{
+
+// Loops of MiccgZeroKernel over a run of ActiveCellsList, the pointers point to the
+// first cell of the run. The scalar operations give the results of the loops over
+// single cells and finish the vector loops.
+
+template <typename ScalarType, typename AccumulatorType>
+struct ScalarRunOperations
+{
+    static inline AccumulatorType multiply(AccumulatorType result, const ScalarType* const left, const ScalarType* const right, const IntegerType count)
+    {
+        for (IntegerType index = 0; index < count; ++index)
+        {
+            result += static_cast<AccumulatorType>(left[index]) * static_cast<AccumulatorType>(right[index]);
+        }
+
+        return result;
+    }
+
+    static inline void sumIn(ScalarType* const target, const ScalarType factorLeft, const ScalarType* const left,
+        const ScalarType factorRight, const ScalarType* const right, const IntegerType count)
+    {
+        for (IntegerType index = 0; index < count; ++index)
+        {
+            target[index] = factorLeft * left[index] + factorRight * right[index];
+        }
+    }
+
+    static inline AccumulatorType maxAbs(AccumulatorType result, const ScalarType* const values, const IntegerType count)
+    {
+        for (IntegerType index = 0; index < count; ++index)
+        {
+            const AccumulatorType currentAbsValue = std::abs(static_cast<AccumulatorType>(values[index]));
+
+            if (currentAbsValue > result)
+            {
+                result = currentAbsValue;
+            }
+        }
+
+        return result;
+    }
+
+    static inline AccumulatorType updateSolutionAndResidual(AccumulatorType result, ScalarType* const solution, ScalarType* const residual,
+        const ScalarType step, const ScalarType* const search, const ScalarType* const product, const IntegerType count)
+    {
+        const ScalarType negativeStep = -step;
+
+        for (IntegerType index = 0; index < count; ++index)
+        {
+            solution[index] = solution[index] + step * search[index];
+
+            const ScalarType residualValue = residual[index] + negativeStep * product[index];
+            residual[index] = residualValue;
+
+            const AccumulatorType currentAbsValue = std::abs(static_cast<AccumulatorType>(residualValue));
+
+            if (currentAbsValue > result)
+            {
+                result = currentAbsValue;
+            }
+        }
+
+        return result;
+    }
+
+    // Product of the stencils with the source, see MiccgZeroKernel::applyMatrixAndMultiplyRun,
+    // and the dot product of the source with it.
+
+    static inline AccumulatorType applyStencils(AccumulatorType result, ScalarType* const target, const ScalarType* const source,
+        const ScalarType* const* const neighbours, const PressureStencil* const stencils, const ScalarType scale, const IntegerType count)
+    {
+        for (IntegerType index = 0; index < count; ++index)
+        {
+            const ScalarType neighboursSum = neighbours[ActiveCellsList::iMinusNeighbour][index]
+                + neighbours[ActiveCellsList::iPlusNeighbour][index]
+                + neighbours[ActiveCellsList::jMinusNeighbour][index]
+                + neighbours[ActiveCellsList::jPlusNeighbour][index]
+                + neighbours[ActiveCellsList::kMinusNeighbour][index]
+                + neighbours[ActiveCellsList::kPlusNeighbour][index];
+
+            const ScalarType diagonal = static_cast<ScalarType>(PressureStencilGrid::diagonal(stencils[index]));
+            const ScalarType value = scale * (diagonal * source[index] - neighboursSum);
+
+            target[index] = value;
+
+            result += static_cast<AccumulatorType>(value) * static_cast<AccumulatorType>(source[index]);
+        }
+
+        return result;
+    }
+
+    // Product of the interleaved coefficients with the source and the dot product of the
+    // source with it. The coefficients hold the diagonal and the couplings with the plus
+    // neighbours, the lower coefficients point to the first i - 1, j - 1 and k - 1 neighbours
+    // of the run, whose y, z and w give the couplings with the minus neighbours.
+
+    static inline AccumulatorType applyCoefficients(AccumulatorType result, ScalarType* const target, const ScalarType* const source,
+        const ScalarType* const* const neighbours, const ScalarFourdDVector<ScalarType>* const coefficients,
+        const ScalarFourdDVector<ScalarType>* const* const lowerCoefficients, const IntegerType count)
+    {
+        for (IntegerType index = 0; index < count; ++index)
+        {
+            const ScalarFourdDVector<ScalarType>& coefficient = coefficients[index];
+
+            const ScalarType spi = neighbours[ActiveCellsList::iPlusNeighbour][index] * coefficient.y;
+            const ScalarType spj = neighbours[ActiveCellsList::jPlusNeighbour][index] * coefficient.z;
+            const ScalarType spk = neighbours[ActiveCellsList::kPlusNeighbour][index] * coefficient.w;
+
+            const ScalarType smi = neighbours[ActiveCellsList::iMinusNeighbour][index] * lowerCoefficients[0][index].y;
+            const ScalarType smj = neighbours[ActiveCellsList::jMinusNeighbour][index] * lowerCoefficients[1][index].z;
+            const ScalarType smk = neighbours[ActiveCellsList::kMinusNeighbour][index] * lowerCoefficients[2][index].w;
+
+            const ScalarType value = source[index] * coefficient.x
+                + spi + spj + spk + smi + smj + smk;
+
+            target[index] = value;
+
+            result += static_cast<AccumulatorType>(value) * static_cast<AccumulatorType>(source[index]);
+        }
+
+        return result;
+    }
+};
+
+#if defined(FLUID_SIMULATIONS_X86_SIMD)
+
+// The vector operations of an instruction set are compiled for it in a region of their
+// own, the loops over the vectors are written once in SimdRunOperationsIsa.hpp.
+
+#if defined(__clang__)
+#define FLUID_SIMULATIONS_SIMD_REGION_BEGIN(isa) _Pragma(FLUID_SIMULATIONS_SIMD_STRINGIFY(clang attribute push(__attribute__((target(isa))), apply_to = function)))
+#define FLUID_SIMULATIONS_SIMD_REGION_END _Pragma("clang attribute pop")
+#elif defined(__GNUC__)
+#define FLUID_SIMULATIONS_SIMD_REGION_BEGIN(isa) _Pragma("GCC push_options") _Pragma(FLUID_SIMULATIONS_SIMD_STRINGIFY(GCC target(isa)))
+#define FLUID_SIMULATIONS_SIMD_REGION_END _Pragma("GCC pop_options")
+#else
+#define FLUID_SIMULATIONS_SIMD_REGION_BEGIN(isa)
+#define FLUID_SIMULATIONS_SIMD_REGION_END
+#endif
+
+#define FLUID_SIMULATIONS_SIMD_STRINGIFY(text) #text
+
+namespace Sse42
+{
+
+FLUID_SIMULATIONS_SIMD_REGION_BEGIN("sse4.2")
+
+template <typename ScalarType>
+struct Vectors;
+
+template <>
+struct Vectors<double>
+{
+    typedef double Scalar;
+    typedef __m128d Vector;
+
+    static const IntegerType width = 2;
+
+    static inline Vector load(const double* const values) { return _mm_loadu_pd(values); }
+    static inline void store(double* const values, const Vector vector) { _mm_storeu_pd(values, vector); }
+    static inline Vector set(const double value) { return _mm_set1_pd(value); }
+    static inline Vector zero() { return _mm_setzero_pd(); }
+    static inline Vector add(const Vector left, const Vector right) { return _mm_add_pd(left, right); }
+    static inline Vector subtract(const Vector left, const Vector right) { return _mm_sub_pd(left, right); }
+    static inline Vector multiply(const Vector left, const Vector right) { return _mm_mul_pd(left, right); }
+    static inline Vector max(const Vector left, const Vector right) { return _mm_max_pd(left, right); }
+    static inline Vector abs(const Vector vector) { return _mm_andnot_pd(_mm_set1_pd(-0.0), vector); }
+
+    static inline Vector loadDiagonals(const PressureStencil* const stencils)
+    {
+        std::int32_t packed;
+        std::memcpy(&packed, stencils, sizeof(packed));
+
+        return _mm_cvtepi32_pd(_mm_srli_epi32(_mm_cvtepu16_epi32(_mm_cvtsi32_si128(packed)), PressureStencilGrid::diagonalShift));
+    }
+
+    static inline void loadComponents(const ScalarFourdDVector<double>* const values, Vector& x, Vector& y, Vector& z, Vector& w)
+    {
+        const Vector xy0 = _mm_loadu_pd(&values[0].x);
+        const Vector zw0 = _mm_loadu_pd(&values[0].z);
+        const Vector xy1 = _mm_loadu_pd(&values[1].x);
+        const Vector zw1 = _mm_loadu_pd(&values[1].z);
+
+        x = _mm_unpacklo_pd(xy0, xy1);
+        y = _mm_unpackhi_pd(xy0, xy1);
+        z = _mm_unpacklo_pd(zw0, zw1);
+        w = _mm_unpackhi_pd(zw0, zw1);
+    }
+};
+
+template <>
+struct Vectors<float>
+{
+    typedef float Scalar;
+    typedef __m128 Vector;
+
+    static const IntegerType width = 4;
+
+    static inline Vector load(const float* const values) { return _mm_loadu_ps(values); }
+    static inline void store(float* const values, const Vector vector) { _mm_storeu_ps(values, vector); }
+    static inline Vector set(const float value) { return _mm_set1_ps(value); }
+    static inline Vector zero() { return _mm_setzero_ps(); }
+    static inline Vector add(const Vector left, const Vector right) { return _mm_add_ps(left, right); }
+    static inline Vector subtract(const Vector left, const Vector right) { return _mm_sub_ps(left, right); }
+    static inline Vector multiply(const Vector left, const Vector right) { return _mm_mul_ps(left, right); }
+    static inline Vector max(const Vector left, const Vector right) { return _mm_max_ps(left, right); }
+    static inline Vector abs(const Vector vector) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), vector); }
+
+    static inline Vector loadDiagonals(const PressureStencil* const stencils)
+    {
+        const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(stencils));
+
+        return _mm_cvtepi32_ps(_mm_srli_epi32(_mm_cvtepu16_epi32(packed), PressureStencilGrid::diagonalShift));
+    }
+
+    static inline void loadComponents(const ScalarFourdDVector<float>* const values, Vector& x, Vector& y, Vector& z, Vector& w)
+    {
+        Vector values0 = _mm_loadu_ps(&values[0].x);
+        Vector values1 = _mm_loadu_ps(&values[1].x);
+        Vector values2 = _mm_loadu_ps(&values[2].x);
+        Vector values3 = _mm_loadu_ps(&values[3].x);
+
+        _MM_TRANSPOSE4_PS(values0, values1, values2, values3);
+
+        x = values0;
+        y = values1;
+        z = values2;
+        w = values3;
+    }
+
+    static inline Vectors<double>::Vector widenLow(const Vector vector) { return _mm_cvtps_pd(vector); }
+    static inline Vectors<double>::Vector widenHigh(const Vector vector) { return _mm_cvtps_pd(_mm_movehl_ps(vector, vector)); }
+};
+
+#include "SimdRunOperationsIsa.hpp"
+
+FLUID_SIMULATIONS_SIMD_REGION_END
+
+}
+
+namespace Avx2
+{
+
+FLUID_SIMULATIONS_SIMD_REGION_BEGIN("avx2")
+
+template <typename ScalarType>
+struct Vectors;
+
+template <>
+struct Vectors<double>
+{
+    typedef double Scalar;
+    typedef __m256d Vector;
+
+    static const IntegerType width = 4;
+
+    static inline Vector load(const double* const values) { return _mm256_loadu_pd(values); }
+    static inline void store(double* const values, const Vector vector) { _mm256_storeu_pd(values, vector); }
+    static inline Vector set(const double value) { return _mm256_set1_pd(value); }
+    static inline Vector zero() { return _mm256_setzero_pd(); }
+    static inline Vector add(const Vector left, const Vector right) { return _mm256_add_pd(left, right); }
+    static inline Vector subtract(const Vector left, const Vector right) { return _mm256_sub_pd(left, right); }
+    static inline Vector multiply(const Vector left, const Vector right) { return _mm256_mul_pd(left, right); }
+    static inline Vector max(const Vector left, const Vector right) { return _mm256_max_pd(left, right); }
+    static inline Vector abs(const Vector vector) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), vector); }
+
+    static inline Vector loadDiagonals(const PressureStencil* const stencils)
+    {
+        const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(stencils));
+
+        return _mm256_cvtepi32_pd(_mm_srli_epi32(_mm_cvtepu16_epi32(packed), PressureStencilGrid::diagonalShift));
+    }
+
+    static inline void loadComponents(const ScalarFourdDVector<double>* const values, Vector& x, Vector& y, Vector& z, Vector& w)
+    {
+        const Vector values0 = _mm256_loadu_pd(&values[0].x);
+        const Vector values1 = _mm256_loadu_pd(&values[1].x);
+        const Vector values2 = _mm256_loadu_pd(&values[2].x);
+        const Vector values3 = _mm256_loadu_pd(&values[3].x);
+
+        const Vector xz01 = _mm256_unpacklo_pd(values0, values1);
+        const Vector yw01 = _mm256_unpackhi_pd(values0, values1);
+        const Vector xz23 = _mm256_unpacklo_pd(values2, values3);
+        const Vector yw23 = _mm256_unpackhi_pd(values2, values3);
+
+        x = _mm256_permute2f128_pd(xz01, xz23, 0x20);
+        y = _mm256_permute2f128_pd(yw01, yw23, 0x20);
+        z = _mm256_permute2f128_pd(xz01, xz23, 0x31);
+        w = _mm256_permute2f128_pd(yw01, yw23, 0x31);
+    }
+};
+
+template <>
+struct Vectors<float>
+{
+    typedef float Scalar;
+    typedef __m256 Vector;
+
+    static const IntegerType width = 8;
+
+    static inline Vector load(const float* const values) { return _mm256_loadu_ps(values); }
+    static inline void store(float* const values, const Vector vector) { _mm256_storeu_ps(values, vector); }
+    static inline Vector set(const float value) { return _mm256_set1_ps(value); }
+    static inline Vector zero() { return _mm256_setzero_ps(); }
+    static inline Vector add(const Vector left, const Vector right) { return _mm256_add_ps(left, right); }
+    static inline Vector subtract(const Vector left, const Vector right) { return _mm256_sub_ps(left, right); }
+    static inline Vector multiply(const Vector left, const Vector right) { return _mm256_mul_ps(left, right); }
+    static inline Vector max(const Vector left, const Vector right) { return _mm256_max_ps(left, right); }
+    static inline Vector abs(const Vector vector) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), vector); }
+
+    static inline Vector loadDiagonals(const PressureStencil* const stencils)
+    {
+        const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(stencils));
+
+        return _mm256_cvtepi32_ps(_mm256_srli_epi32(_mm256_cvtepu16_epi32(packed), PressureStencilGrid::diagonalShift));
+    }
+
+    // Transposes the cells 0 to 3 and 4 to 7 in the two halves of the vectors.
+
+    static inline void loadComponents(const ScalarFourdDVector<float>* const values, Vector& x, Vector& y, Vector& z, Vector& w)
+    {
+        const Vector values01 = _mm256_loadu_ps(&values[0].x);
+        const Vector values23 = _mm256_loadu_ps(&values[2].x);
+        const Vector values45 = _mm256_loadu_ps(&values[4].x);
+        const Vector values67 = _mm256_loadu_ps(&values[6].x);
+
+        const Vector values04 = _mm256_permute2f128_ps(values01, values45, 0x20);
+        const Vector values15 = _mm256_permute2f128_ps(values01, values45, 0x31);
+        const Vector values26 = _mm256_permute2f128_ps(values23, values67, 0x20);
+        const Vector values37 = _mm256_permute2f128_ps(values23, values67, 0x31);
+
+        const Vector xy01 = _mm256_unpacklo_ps(values04, values15);
+        const Vector zw01 = _mm256_unpackhi_ps(values04, values15);
+        const Vector xy23 = _mm256_unpacklo_ps(values26, values37);
+        const Vector zw23 = _mm256_unpackhi_ps(values26, values37);
+
+        x = _mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(1, 0, 1, 0));
+        y = _mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 2, 3, 2));
+        z = _mm256_shuffle_ps(zw01, zw23, _MM_SHUFFLE(1, 0, 1, 0));
+        w = _mm256_shuffle_ps(zw01, zw23, _MM_SHUFFLE(3, 2, 3, 2));
+    }
+
+    static inline Vectors<double>::Vector widenLow(const Vector vector) { return _mm256_cvtps_pd(_mm256_castps256_ps128(vector)); }
+    static inline Vectors<double>::Vector widenHigh(const Vector vector) { return _mm256_cvtps_pd(_mm256_extractf128_ps(vector, 1)); }
+};
+
+#include "SimdRunOperationsIsa.hpp"
+
+FLUID_SIMULATIONS_SIMD_REGION_END
+
+}
+
+namespace Avx512
+{
+
+FLUID_SIMULATIONS_SIMD_REGION_BEGIN("avx512f")
+
+// The zero masked forms of the operations which leave the inactive lanes undefined
+// otherwise, the undefined lanes set off uninitialized value warnings.
+
+template <typename ScalarType>
+struct Vectors;
+
+template <>
+struct Vectors<double>
+{
+    typedef double Scalar;
+    typedef __m512d Vector;
+
+    static const IntegerType width = 8;
+    static const __mmask8 allLanes = 0xff;
+
+    static inline Vector load(const double* const values) { return _mm512_loadu_pd(values); }
+    static inline void store(double* const values, const Vector vector) { _mm512_storeu_pd(values, vector); }
+    static inline Vector set(const double value) { return _mm512_set1_pd(value); }
+    static inline Vector zero() { return _mm512_setzero_pd(); }
+    static inline Vector add(const Vector left, const Vector right) { return _mm512_add_pd(left, right); }
+    static inline Vector subtract(const Vector left, const Vector right) { return _mm512_sub_pd(left, right); }
+    static inline Vector multiply(const Vector left, const Vector right) { return _mm512_mul_pd(left, right); }
+    static inline Vector max(const Vector left, const Vector right) { return _mm512_maskz_max_pd(allLanes, left, right); }
+    static inline Vector abs(const Vector vector) { return _mm512_abs_pd(vector); }
+
+    static inline Vector loadDiagonals(const PressureStencil* const stencils)
+    {
+        const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(stencils));
+
+        return _mm512_maskz_cvtepi32_pd(allLanes, _mm256_srli_epi32(_mm256_cvtepu16_epi32(packed), PressureStencilGrid::diagonalShift));
+    }
+
+    // Gathers the components of the cells 0 to 3 and 4 to 7 in the halves of the vectors
+    // and joins the halves.
+
+    static inline void loadComponents(const ScalarFourdDVector<double>* const values, Vector& x, Vector& y, Vector& z, Vector& w)
+    {
+        const __m512i xyIndices = _mm512_set_epi64(13, 9, 5, 1, 12, 8, 4, 0);
+        const __m512i zwIndices = _mm512_set_epi64(15, 11, 7, 3, 14, 10, 6, 2);
+
+        const __m512i lowHalves = _mm512_set_epi64(11, 10, 9, 8, 3, 2, 1, 0);
+        const __m512i highHalves = _mm512_set_epi64(15, 14, 13, 12, 7, 6, 5, 4);
+
+        const Vector values01 = _mm512_loadu_pd(&values[0].x);
+        const Vector values23 = _mm512_loadu_pd(&values[2].x);
+        const Vector values45 = _mm512_loadu_pd(&values[4].x);
+        const Vector values67 = _mm512_loadu_pd(&values[6].x);
+
+        const Vector xy0123 = _mm512_permutex2var_pd(values01, xyIndices, values23);
+        const Vector zw0123 = _mm512_permutex2var_pd(values01, zwIndices, values23);
+        const Vector xy4567 = _mm512_permutex2var_pd(values45, xyIndices, values67);
+        const Vector zw4567 = _mm512_permutex2var_pd(values45, zwIndices, values67);
+
+        x = _mm512_permutex2var_pd(xy0123, lowHalves, xy4567);
+        y = _mm512_permutex2var_pd(xy0123, highHalves, xy4567);
+        z = _mm512_permutex2var_pd(zw0123, lowHalves, zw4567);
+        w = _mm512_permutex2var_pd(zw0123, highHalves, zw4567);
+    }
+};
+
+template <>
+struct Vectors<float>
+{
+    typedef float Scalar;
+    typedef __m512 Vector;
+
+    static const IntegerType width = 16;
+    static const __mmask16 allLanes = 0xffff;
+
+    static inline Vector load(const float* const values) { return _mm512_loadu_ps(values); }
+    static inline void store(float* const values, const Vector vector) { _mm512_storeu_ps(values, vector); }
+    static inline Vector set(const float value) { return _mm512_set1_ps(value); }
+    static inline Vector zero() { return _mm512_setzero_ps(); }
+    static inline Vector add(const Vector left, const Vector right) { return _mm512_add_ps(left, right); }
+    static inline Vector subtract(const Vector left, const Vector right) { return _mm512_sub_ps(left, right); }
+    static inline Vector multiply(const Vector left, const Vector right) { return _mm512_mul_ps(left, right); }
+    static inline Vector max(const Vector left, const Vector right) { return _mm512_maskz_max_ps(allLanes, left, right); }
+    static inline Vector abs(const Vector vector) { return _mm512_abs_ps(vector); }
+
+    static inline Vector loadDiagonals(const PressureStencil* const stencils)
+    {
+        const __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stencils));
+
+        const __m512i diagonals = _mm512_maskz_srli_epi32(allLanes, _mm512_maskz_cvtepu16_epi32(allLanes, packed), PressureStencilGrid::diagonalShift);
+
+        return _mm512_maskz_cvtepi32_ps(allLanes, diagonals);
+    }
+
+    // Gathers the components of the cells 0 to 7 and 8 to 15 in the halves of the vectors
+    // and joins the halves.
+
+    static inline void loadComponents(const ScalarFourdDVector<float>* const values, Vector& x, Vector& y, Vector& z, Vector& w)
+    {
+        const __m512i xyIndices = _mm512_set_epi32(29, 25, 21, 17, 13, 9, 5, 1, 28, 24, 20, 16, 12, 8, 4, 0);
+        const __m512i zwIndices = _mm512_set_epi32(31, 27, 23, 19, 15, 11, 7, 3, 30, 26, 22, 18, 14, 10, 6, 2);
+
+        const __m512i lowHalves = _mm512_set_epi32(23, 22, 21, 20, 19, 18, 17, 16, 7, 6, 5, 4, 3, 2, 1, 0);
+        const __m512i highHalves = _mm512_set_epi32(31, 30, 29, 28, 27, 26, 25, 24, 15, 14, 13, 12, 11, 10, 9, 8);
+
+        const Vector values0 = _mm512_loadu_ps(&values[0].x);
+        const Vector values4 = _mm512_loadu_ps(&values[4].x);
+        const Vector values8 = _mm512_loadu_ps(&values[8].x);
+        const Vector values12 = _mm512_loadu_ps(&values[12].x);
+
+        const Vector xyLow = _mm512_permutex2var_ps(values0, xyIndices, values4);
+        const Vector zwLow = _mm512_permutex2var_ps(values0, zwIndices, values4);
+        const Vector xyHigh = _mm512_permutex2var_ps(values8, xyIndices, values12);
+        const Vector zwHigh = _mm512_permutex2var_ps(values8, zwIndices, values12);
+
+        x = _mm512_permutex2var_ps(xyLow, lowHalves, xyHigh);
+        y = _mm512_permutex2var_ps(xyLow, highHalves, xyHigh);
+        z = _mm512_permutex2var_ps(zwLow, lowHalves, zwHigh);
+        w = _mm512_permutex2var_ps(zwLow, highHalves, zwHigh);
+    }
+
+    static inline Vectors<double>::Vector widenLow(const Vector vector) { return widenHalf<0>(vector); }
+    static inline Vectors<double>::Vector widenHigh(const Vector vector) { return widenHalf<1>(vector); }
+
+    template <int half>
+    static inline Vectors<double>::Vector widenHalf(const Vector vector)
+    {
+        const __m256d values = _mm512_maskz_extractf64x4_pd(Vectors<double>::allLanes, _mm512_castps_pd(vector), half);
+
+        return _mm512_maskz_cvtps_pd(Vectors<double>::allLanes, _mm256_castpd_ps(values));
+    }
+};
+
+#include "SimdRunOperationsIsa.hpp"
+
+FLUID_SIMULATIONS_SIMD_REGION_END
+
+}
+
+#endif
+
+// Runs the operations of the given level. The vectors hold ScalarType, the operations
+// with double accumulators over floats widen the lanes, see MixedRunOperations.
+
+#if defined(FLUID_SIMULATIONS_X86_SIMD)
+
+#define FLUID_SIMULATIONS_SIMD_DISPATCH(level, operation, ...) \
+    switch (level) \
+    { \
+    case avx512SimdLevel: \
+        return Avx512::AccumulatingRunOperations<ScalarType, AccumulatorType>::Type::operation(__VA_ARGS__); \
+    case avx2SimdLevel: \
+        return Avx2::AccumulatingRunOperations<ScalarType, AccumulatorType>::Type::operation(__VA_ARGS__); \
+    case sse42SimdLevel: \
+        return Sse42::AccumulatingRunOperations<ScalarType, AccumulatorType>::Type::operation(__VA_ARGS__); \
+    default: \
+        return ScalarRunOperations<ScalarType, AccumulatorType>::operation(__VA_ARGS__); \
+    }
+
+#else
+
+#define FLUID_SIMULATIONS_SIMD_DISPATCH(level, operation, ...) \
+    static_cast<void>(level); \
+    return ScalarRunOperations<ScalarType, AccumulatorType>::operation(__VA_ARGS__);
+
+#endif
+
+template <typename ScalarType, typename AccumulatorType>
+struct SimdRunOperations
+{
+    static inline AccumulatorType multiply(const SimdLevel level, const AccumulatorType result,
+        const ScalarType* const left, const ScalarType* const right, const IntegerType count)
+    {
+        FLUID_SIMULATIONS_SIMD_DISPATCH(level, multiply, result, left, right, count)
+    }
+
+    static inline void sumIn(const SimdLevel level, ScalarType* const target, const ScalarType factorLeft, const ScalarType* const left,
+        const ScalarType factorRight, const ScalarType* const right, const IntegerType count)
+    {
+        FLUID_SIMULATIONS_SIMD_DISPATCH(level, sumIn, target, factorLeft, left, factorRight, right, count)
+    }
+
+    static inline AccumulatorType maxAbs(const SimdLevel level, const AccumulatorType result, const ScalarType* const values, const IntegerType count)
+    {
+        FLUID_SIMULATIONS_SIMD_DISPATCH(level, maxAbs, result, values, count)
+    }
+
+    static inline AccumulatorType updateSolutionAndResidual(const SimdLevel level, const AccumulatorType result, ScalarType* const solution,
+        ScalarType* const residual, const ScalarType step, const ScalarType* const search, const ScalarType* const product, const IntegerType count)
+    {
+        FLUID_SIMULATIONS_SIMD_DISPATCH(level, updateSolutionAndResidual, result, solution, residual, step, search, product, count)
+    }
+
+    static inline AccumulatorType applyStencils(const SimdLevel level, const AccumulatorType result, ScalarType* const target, const ScalarType* const source,
+        const ScalarType* const* const neighbours, const PressureStencil* const stencils, const ScalarType scale, const IntegerType count)
+    {
+        FLUID_SIMULATIONS_SIMD_DISPATCH(level, applyStencils, result, target, source, neighbours, stencils, scale, count)
+    }
+
+    static inline AccumulatorType applyCoefficients(const SimdLevel level, const AccumulatorType result, ScalarType* const target,
+        const ScalarType* const source, const ScalarType* const* const neighbours, const ScalarFourdDVector<ScalarType>* const coefficients,
+        const ScalarFourdDVector<ScalarType>* const* const lowerCoefficients, const IntegerType count)
+    {
+        FLUID_SIMULATIONS_SIMD_DISPATCH(level, applyCoefficients, result, target, source, neighbours, coefficients, lowerCoefficients, count)
+    }
+};
+
+#undef FLUID_SIMULATIONS_SIMD_DISPATCH
+
+}
+
+}
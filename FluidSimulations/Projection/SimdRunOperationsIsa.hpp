@@ -0,0 +1,291 @@
+// The loops of SimdRunOperations over the vectors of an instruction set, included in its
+// namespace and region by SimdRunOperations.hpp, so the header has no include guard.
+// The lanes are summed and compared in their order after the loops, the cells which
+// do not fill a vector go through ScalarRunOperations. The products are added up in the
+// order of the scalar loops.
+
+template <typename VectorsType>
+struct RunOperations
+{
+    typedef typename VectorsType::Scalar ScalarType;
+    typedef typename VectorsType::Vector VectorType;
+
+    typedef ScalarRunOperations<ScalarType, ScalarType> TailOperations;
+
+    static const IntegerType width = VectorsType::width;
+
+    static inline ScalarType multiply(const ScalarType result, const ScalarType* const left, const ScalarType* const right, const IntegerType count)
+    {
+        VectorType sum = VectorsType::zero();
+
+        IntegerType index = 0;
+
+        for (; index + width <= count; index += width)
+        {
+            sum = VectorsType::add(sum, VectorsType::multiply(VectorsType::load(left + index), VectorsType::load(right + index)));
+        }
+
+        return TailOperations::multiply(result + laneSum(sum), left + index, right + index, count - index);
+    }
+
+    static inline void sumIn(ScalarType* const target, const ScalarType factorLeft, const ScalarType* const left,
+        const ScalarType factorRight, const ScalarType* const right, const IntegerType count)
+    {
+        const VectorType leftFactors = VectorsType::set(factorLeft);
+        const VectorType rightFactors = VectorsType::set(factorRight);
+
+        IntegerType index = 0;
+
+        for (; index + width <= count; index += width)
+        {
+            VectorsType::store(target + index, VectorsType::add(
+                VectorsType::multiply(leftFactors, VectorsType::load(left + index)),
+                VectorsType::multiply(rightFactors, VectorsType::load(right + index))));
+        }
+
+        TailOperations::sumIn(target + index, factorLeft, left + index, factorRight, right + index, count - index);
+    }
+
+    static inline ScalarType maxAbs(const ScalarType result, const ScalarType* const values, const IntegerType count)
+    {
+        VectorType maxAbsValues = VectorsType::zero();
+
+        IntegerType index = 0;
+
+        for (; index + width <= count; index += width)
+        {
+            maxAbsValues = VectorsType::max(maxAbsValues, VectorsType::abs(VectorsType::load(values + index)));
+        }
+
+        return TailOperations::maxAbs(std::max(result, laneMax(maxAbsValues)), values + index, count - index);
+    }
+
+    static inline ScalarType updateSolutionAndResidual(const ScalarType result, ScalarType* const solution, ScalarType* const residual,
+        const ScalarType step, const ScalarType* const search, const ScalarType* const product, const IntegerType count)
+    {
+        const VectorType steps = VectorsType::set(step);
+        const VectorType negativeSteps = VectorsType::set(-step);
+
+        VectorType maxAbsValues = VectorsType::zero();
+
+        IntegerType index = 0;
+
+        for (; index + width <= count; index += width)
+        {
+            VectorsType::store(solution + index, VectorsType::add(VectorsType::load(solution + index),
+                VectorsType::multiply(steps, VectorsType::load(search + index))));
+
+            const VectorType residualValues = VectorsType::add(VectorsType::load(residual + index),
+                VectorsType::multiply(negativeSteps, VectorsType::load(product + index)));
+
+            VectorsType::store(residual + index, residualValues);
+
+            maxAbsValues = VectorsType::max(maxAbsValues, VectorsType::abs(residualValues));
+        }
+
+        return TailOperations::updateSolutionAndResidual(std::max(result, laneMax(maxAbsValues)), solution + index, residual + index,
+            step, search + index, product + index, count - index);
+    }
+
+    static inline ScalarType applyStencils(const ScalarType result, ScalarType* const target, const ScalarType* const source,
+        const ScalarType* const* const neighbours, const PressureStencil* const stencils, const ScalarType scale, const IntegerType count)
+    {
+        const VectorType scales = VectorsType::set(scale);
+
+        VectorType sum = VectorsType::zero();
+
+        IntegerType index = 0;
+
+        for (; index + width <= count; index += width)
+        {
+            VectorType neighboursSum = VectorsType::add(
+                VectorsType::load(neighbours[ActiveCellsList::iMinusNeighbour] + index),
+                VectorsType::load(neighbours[ActiveCellsList::iPlusNeighbour] + index));
+
+            neighboursSum = VectorsType::add(neighboursSum, VectorsType::load(neighbours[ActiveCellsList::jMinusNeighbour] + index));
+            neighboursSum = VectorsType::add(neighboursSum, VectorsType::load(neighbours[ActiveCellsList::jPlusNeighbour] + index));
+            neighboursSum = VectorsType::add(neighboursSum, VectorsType::load(neighbours[ActiveCellsList::kMinusNeighbour] + index));
+            neighboursSum = VectorsType::add(neighboursSum, VectorsType::load(neighbours[ActiveCellsList::kPlusNeighbour] + index));
+
+            const VectorType sourceValues = VectorsType::load(source + index);
+
+            const VectorType values = VectorsType::multiply(scales, VectorsType::subtract(
+                VectorsType::multiply(VectorsType::loadDiagonals(stencils + index), sourceValues), neighboursSum));
+
+            VectorsType::store(target + index, values);
+
+            sum = VectorsType::add(sum, VectorsType::multiply(values, sourceValues));
+        }
+
+        const ScalarType* tailNeighbours[ActiveCellsList::neighboursCount];
+
+        for (IntegerType neighbour = 0; neighbour < ActiveCellsList::neighboursCount; ++neighbour)
+        {
+            tailNeighbours[neighbour] = neighbours[neighbour] + index;
+        }
+
+        return TailOperations::applyStencils(result + laneSum(sum), target + index, source + index, tailNeighbours, stencils + index, scale, count - index);
+    }
+
+    static inline ScalarType applyCoefficients(const ScalarType result, ScalarType* const target, const ScalarType* const source,
+        const ScalarType* const* const neighbours, const ScalarFourdDVector<ScalarType>* const coefficients,
+        const ScalarFourdDVector<ScalarType>* const* const lowerCoefficients, const IntegerType count)
+    {
+        VectorType sum = VectorsType::zero();
+
+        IntegerType index = 0;
+
+        for (; index + width <= count; index += width)
+        {
+            VectorType diagonals, iPlusCouplings, jPlusCouplings, kPlusCouplings;
+            VectorsType::loadComponents(coefficients + index, diagonals, iPlusCouplings, jPlusCouplings, kPlusCouplings);
+
+            VectorType unused, iMinusCouplings, jMinusCouplings, kMinusCouplings;
+            VectorsType::loadComponents(lowerCoefficients[0] + index, unused, iMinusCouplings, unused, unused);
+            VectorsType::loadComponents(lowerCoefficients[1] + index, unused, unused, jMinusCouplings, unused);
+            VectorsType::loadComponents(lowerCoefficients[2] + index, unused, unused, unused, kMinusCouplings);
+
+            const VectorType sourceValues = VectorsType::load(source + index);
+
+            VectorType values = VectorsType::multiply(sourceValues, diagonals);
+
+            values = VectorsType::add(values, VectorsType::multiply(VectorsType::load(neighbours[ActiveCellsList::iPlusNeighbour] + index), iPlusCouplings));
+            values = VectorsType::add(values, VectorsType::multiply(VectorsType::load(neighbours[ActiveCellsList::jPlusNeighbour] + index), jPlusCouplings));
+            values = VectorsType::add(values, VectorsType::multiply(VectorsType::load(neighbours[ActiveCellsList::kPlusNeighbour] + index), kPlusCouplings));
+            values = VectorsType::add(values, VectorsType::multiply(VectorsType::load(neighbours[ActiveCellsList::iMinusNeighbour] + index), iMinusCouplings));
+            values = VectorsType::add(values, VectorsType::multiply(VectorsType::load(neighbours[ActiveCellsList::jMinusNeighbour] + index), jMinusCouplings));
+            values = VectorsType::add(values, VectorsType::multiply(VectorsType::load(neighbours[ActiveCellsList::kMinusNeighbour] + index), kMinusCouplings));
+
+            VectorsType::store(target + index, values);
+
+            sum = VectorsType::add(sum, VectorsType::multiply(values, sourceValues));
+        }
+
+        const ScalarType* tailNeighbours[ActiveCellsList::neighboursCount];
+
+        for (IntegerType neighbour = 0; neighbour < ActiveCellsList::neighboursCount; ++neighbour)
+        {
+            tailNeighbours[neighbour] = neighbours[neighbour] + index;
+        }
+
+        const ScalarFourdDVector<ScalarType>* const tailLowerCoefficients[] =
+        {
+            lowerCoefficients[0] + index, lowerCoefficients[1] + index, lowerCoefficients[2] + index
+        };
+
+        return TailOperations::applyCoefficients(result + laneSum(sum), target + index, source + index, tailNeighbours,
+            coefficients + index, tailLowerCoefficients, count - index);
+    }
+
+    static inline ScalarType laneSum(const VectorType vector)
+    {
+        ScalarType lanes[width];
+        VectorsType::store(lanes, vector);
+
+        ScalarType result = 0;
+
+        for (IntegerType lane = 0; lane < width; ++lane)
+        {
+            result += lanes[lane];
+        }
+
+        return result;
+    }
+
+    static inline ScalarType laneMax(const VectorType vector)
+    {
+        ScalarType lanes[width];
+        VectorsType::store(lanes, vector);
+
+        return *std::max_element(lanes, lanes + width);
+    }
+};
+
+// The operations over vectors of floats which accumulate in doubles. The dot products
+// widen the lanes to doubles, the values and the stop rates of the float operations are
+// exact in doubles, so those run the float operations and widen their results.
+
+template <typename VectorsType, typename AccumulatorVectorsType>
+struct MixedRunOperations
+{
+    typedef typename VectorsType::Scalar ScalarType;
+    typedef typename VectorsType::Vector VectorType;
+
+    typedef typename AccumulatorVectorsType::Scalar AccumulatorType;
+    typedef typename AccumulatorVectorsType::Vector AccumulatorVectorType;
+
+    typedef RunOperations<VectorsType> NarrowOperations;
+    typedef ScalarRunOperations<ScalarType, AccumulatorType> TailOperations;
+
+    static const IntegerType width = VectorsType::width;
+
+    static inline AccumulatorType multiply(const AccumulatorType result, const ScalarType* const left, const ScalarType* const right, const IntegerType count)
+    {
+        AccumulatorVectorType sum = AccumulatorVectorsType::zero();
+
+        IntegerType index = 0;
+
+        for (; index + width <= count; index += width)
+        {
+            const VectorType leftValues = VectorsType::load(left + index);
+            const VectorType rightValues = VectorsType::load(right + index);
+
+            sum = AccumulatorVectorsType::add(sum, AccumulatorVectorsType::multiply(VectorsType::widenLow(leftValues), VectorsType::widenLow(rightValues)));
+            sum = AccumulatorVectorsType::add(sum, AccumulatorVectorsType::multiply(VectorsType::widenHigh(leftValues), VectorsType::widenHigh(rightValues)));
+        }
+
+        return TailOperations::multiply(result + RunOperations<AccumulatorVectorsType>::laneSum(sum), left + index, right + index, count - index);
+    }
+
+    static inline void sumIn(ScalarType* const target, const ScalarType factorLeft, const ScalarType* const left,
+        const ScalarType factorRight, const ScalarType* const right, const IntegerType count)
+    {
+        NarrowOperations::sumIn(target, factorLeft, left, factorRight, right, count);
+    }
+
+    static inline AccumulatorType maxAbs(const AccumulatorType result, const ScalarType* const values, const IntegerType count)
+    {
+        return std::max(result, static_cast<AccumulatorType>(NarrowOperations::maxAbs(0, values, count)));
+    }
+
+    static inline AccumulatorType updateSolutionAndResidual(const AccumulatorType result, ScalarType* const solution, ScalarType* const residual,
+        const ScalarType step, const ScalarType* const search, const ScalarType* const product, const IntegerType count)
+    {
+        return std::max(result, static_cast<AccumulatorType>(
+            NarrowOperations::updateSolutionAndResidual(0, solution, residual, step, search, product, count)));
+    }
+
+    // The products run the float operations and take the dot product of the run again, the
+    // run is in the cache still.
+
+    static inline AccumulatorType applyStencils(const AccumulatorType result, ScalarType* const target, const ScalarType* const source,
+        const ScalarType* const* const neighbours, const PressureStencil* const stencils, const ScalarType scale, const IntegerType count)
+    {
+        NarrowOperations::applyStencils(0, target, source, neighbours, stencils, scale, count);
+
+        return multiply(result, target, source, count);
+    }
+
+    static inline AccumulatorType applyCoefficients(const AccumulatorType result, ScalarType* const target, const ScalarType* const source,
+        const ScalarType* const* const neighbours, const ScalarFourdDVector<ScalarType>* const coefficients,
+        const ScalarFourdDVector<ScalarType>* const* const lowerCoefficients, const IntegerType count)
+    {
+        NarrowOperations::applyCoefficients(0, target, source, neighbours, coefficients, lowerCoefficients, count);
+
+        return multiply(result, target, source, count);
+    }
+};
+
+// The operations of the vectors of ScalarType with AccumulatorType results.
+
+template <typename ScalarType, typename AccumulatorType>
+struct AccumulatingRunOperations
+{
+    typedef MixedRunOperations<Vectors<ScalarType>, Vectors<AccumulatorType>> Type;
+};
+
+template <typename ScalarType>
+struct AccumulatingRunOperations<ScalarType, ScalarType>
+{
+    typedef RunOperations<Vectors<ScalarType>> Type;
+};
@@ -2,6 +2,7 @@
 
 #include "../IMovement.hpp"
 #include "../GridOperations.hpp"
+#include "../MacVelocityGrid.hpp"
 #include "IPressureSolver.hpp"
 #include "IPressureSolverPreparator.hpp"
 
@@ -23,7 +24,7 @@ class VelocityProjectionMovement
 {
 public:
     VelocityProjectionMovement(
-        const FloatsThreeDVectorGridPtr& velocity,
+        const MacVelocityGridPtr& velocity,
         const FloatsGridConstPtr& pressure,
         const FluidPredicateSpaceType& fluidPredicate,
         const SolidPredicateSpaceType& solidPredicate,
@@ -58,6 +59,10 @@ private:
     {
         const FloatType scale = timeInterval / m_fluidDensity;
 
+        FloatsGrid& iVelocity = *m_velocity->iComponent();
+        FloatsGrid& jVelocity = *m_velocity->jComponent();
+        FloatsGrid& kVelocity = *m_velocity->kComponent();
+
         for (IntegerType i = 0; i < m_pressure->iRes(); ++i)
         {
             for (IntegerType j = 0; j < m_pressure->jRes(); ++j)
@@ -68,23 +73,27 @@ private:
                     {
                         const FloatType pValue = scale * m_pressure->at(i, j, k);
 
-                        m_velocity->at(i, j, k).x -= pValue;
-                        m_velocity->at(i + 1, j, k).x += pValue;
+                        iVelocity.at(i, j, k) -= pValue;
+                        iVelocity.at(i + 1, j, k) += pValue;
 
-                        m_velocity->at(i, j, k).y -= pValue;
-                        m_velocity->at(i, j + 1, k).y += pValue;
+                        jVelocity.at(i, j, k) -= pValue;
+                        jVelocity.at(i, j + 1, k) += pValue;
 
-                        m_velocity->at(i, j, k).z -= pValue;
-                        m_velocity->at(i, j, k + 1).z += pValue;
+                        kVelocity.at(i, j, k) -= pValue;
+                        kVelocity.at(i, j, k + 1) += pValue;
                     }
 
                     if (m_solidPredicate.at(i, j, k))
                     {
-                        m_velocity->at(i, j, k) = m_solidVelocity.at(i, j, k);
+                        const FloatsThreeDVector solidVelocity = m_solidVelocity.at(i, j, k);
+
+                        iVelocity.at(i, j, k) = solidVelocity.x;
+                        jVelocity.at(i, j, k) = solidVelocity.y;
+                        kVelocity.at(i, j, k) = solidVelocity.z;
 
-                        m_velocity->at(i + 1, j, k).x = m_solidVelocity.at(i + 1, j, k).x;
-                        m_velocity->at(i, j + 1, k).y = m_solidVelocity.at(i, j + 1, k).y;
-                        m_velocity->at(i, j, k + 1).z = m_solidVelocity.at(i, j, k + 1).z;
+                        iVelocity.at(i + 1, j, k) = m_solidVelocity.at(i + 1, j, k).x;
+                        jVelocity.at(i, j + 1, k) = m_solidVelocity.at(i, j + 1, k).y;
+                        kVelocity.at(i, j, k + 1) = m_solidVelocity.at(i, j, k + 1).z;
                     }
                 }
             }
@@ -92,7 +101,7 @@ private:
     }
 
 private:
-    const FloatsThreeDVectorGridPtr m_velocity;
+    const MacVelocityGridPtr m_velocity;
     const FloatsGridConstPtr m_pressure;
 
     const FluidPredicateSpaceType m_fluidPredicate;
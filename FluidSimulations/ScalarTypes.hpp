@@ -3,7 +3,11 @@
 namespace FluidSimulations
 {
 
+#ifdef FLUID_SIMULATIONS_SINGLE_PRECISION
+typedef float FloatType;
+#else
 typedef double FloatType;
+#endif
 
 typedef int IntegerType;
 
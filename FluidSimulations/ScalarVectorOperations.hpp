@@ -119,7 +119,7 @@ inline ScalarThreeDVector<ScalarType> minus(const ScalarThreeDVector<ScalarType>
 template <typename ScalarType>
 inline FloatType norm(const ScalarThreeDVector<ScalarType>& target)
 {
-    return sqrt(target.x * target.x + target.y * target.y + target.z * target.z);
+    return std::sqrt(target.x * target.x + target.y * target.y + target.z * target.z);
 }
 
 template <typename ScalarType>
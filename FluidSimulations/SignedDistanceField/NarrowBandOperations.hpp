@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../GridOperations.hpp"
+
+#include <cmath>
+
+namespace FluidSimulations
+{
+
+namespace SignedDistanceField
+{
+
+template <typename LayoutType>
+inline void pruneNarrowBand(Grid<FloatType, LayoutType>&, const FloatType)
+{
+}
+
+template <typename FunctorType>
+inline void buildNarrowBand(SparseFloatsGrid& signedDistance, const FloatType bandWidth, FunctorType sdf)
+{
+    const IntegerType leafSize = SparseFloatsGrid::leafSize;
+
+    for (IntegerType iOrigin = 0; iOrigin < signedDistance.iRes(); iOrigin += leafSize)
+    {
+        for (IntegerType jOrigin = 0; jOrigin < signedDistance.jRes(); jOrigin += leafSize)
+        {
+            for (IntegerType kOrigin = 0; kOrigin < signedDistance.kRes(); kOrigin += leafSize)
+            {
+                const FloatType halfSize = static_cast<FloatType>(leafSize) * 0.5f;
+                const FloatType centerDistance = sdf(iOrigin + halfSize, jOrigin + halfSize, kOrigin + halfSize);
+
+                if (std::abs(centerDistance) > bandWidth + halfSize * std::sqrt(static_cast<FloatType>(3)))
+                {
+                    signedDistance.setTile(iOrigin, jOrigin, kOrigin,
+                        centerDistance < 0 ? -signedDistance.background() : signedDistance.background());
+
+                    continue;
+                }
+
+                for (IntegerType i = iOrigin; i < std::min(iOrigin + leafSize, signedDistance.iRes()); ++i)
+                {
+                    for (IntegerType j = jOrigin; j < std::min(jOrigin + leafSize, signedDistance.jRes()); ++j)
+                    {
+                        for (IntegerType k = kOrigin; k < std::min(kOrigin + leafSize, signedDistance.kRes()); ++k)
+                        {
+                            signedDistance.at(i, j, k) = sdf(static_cast<FloatType>(i), static_cast<FloatType>(j), static_cast<FloatType>(k));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+inline void pruneNarrowBand(SparseFloatsGrid& signedDistance, const FloatType bandWidth)
+{
+    const SparseFloatsGrid& constSignedDistance = signedDistance;
+
+    forEachTile(constSignedDistance, [&](const IntegersThreeDVector& begin, const IntegersThreeDVector& end) -> void
+    {
+        for (IntegerType i = begin.x; i < end.x; ++i)
+        {
+            for (IntegerType j = begin.y; j < end.y; ++j)
+            {
+                for (IntegerType k = begin.z; k < end.z; ++k)
+                {
+                    if (std::abs(constSignedDistance.at(i, j, k)) <= bandWidth)
+                    {
+                        return;
+                    }
+                }
+            }
+        }
+
+        const FloatType background = signedDistance.background();
+
+        signedDistance.setTile(begin.x, begin.y, begin.z,
+            constSignedDistance.at(begin.x, begin.y, begin.z) < 0 ? -background : background);
+    });
+}
+
+}
+
+}
@@ -4,6 +4,8 @@
 #include "../RigidGridBoundary.hpp"
 #include "NearestSurfacePointCalculator.hpp"
 
+#include <cmath>
+
 namespace FluidSimulations
 {
 
@@ -31,6 +33,12 @@ public:
 
         const FloatsThreeDVector s = m_nearestSurfacePoint.at(b.x, b.y, b.z);
 
+        // The background of a sparse field is flat and gives no direction to the surface.
+        if (!std::isfinite(s.x) || !std::isfinite(s.y) || !std::isfinite(s.z))
+        {
+            return m_signedDistanceSpace.at(b.x, b.y, b.z) + distance(b, p);
+        }
+
         return distance(s, p);
     }
 
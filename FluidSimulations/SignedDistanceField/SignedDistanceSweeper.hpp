@@ -1,11 +1,14 @@
 #pragma once
 
+#include "../GridArena.hpp"
 #include "../GridOperations.hpp"
 #include "../ScalarVectorOperations.hpp"
 #include "ISignedDistanceTracker.hpp"
+#include "NarrowBandOperations.hpp"
 #include "NearestSurfacePointCalculator.hpp"
 
 #include <cmath>
+#include <cstdint>
 
 namespace FluidSimulations
 {
@@ -13,18 +16,30 @@ namespace FluidSimulations
 namespace SignedDistanceField
 {
 
-template <typename FloatsSpaceType>
+template <typename FloatsSpaceType, typename FloatsGridType = FloatsGrid>
 class SignedDistanceSweeper
     : public ISignedDistanceTracker
 {
 public:
+    typedef std::shared_ptr<FloatsGridType> FloatsGridTypePtr;
+
     SignedDistanceSweeper(
-        const FloatsGridPtr& signedDistance,
-        const FloatsSpaceType& signedDistanceApproximator)
+        const FloatsGridTypePtr& signedDistance,
+        const FloatsSpaceType& signedDistanceApproximator,
+        const FloatType narrowBandWidth = static_cast<FloatType>(4))
+        : SignedDistanceSweeper(signedDistance, signedDistanceApproximator, narrowBandWidth, std::make_shared<GridArena>())
+    {
+    }
+
+    SignedDistanceSweeper(
+        const FloatsGridTypePtr& signedDistance,
+        const FloatsSpaceType& signedDistanceApproximator,
+        const FloatType narrowBandWidth,
+        const GridArenaPtr& arena)
         : m_signedDistance(signedDistance)
         , m_nearestSurfacePoint(NearestSurfacePointCalculator<FloatsSpaceType>(signedDistanceApproximator))
-        , m_knownPoints(std::make_shared<Grid<bool>>(signedDistance->iRes(), signedDistance->jRes(), signedDistance->kRes()))
-        , m_closestSurfacePoints(std::make_shared<Grid<FloatsThreeDVector>>(signedDistance->iRes(), signedDistance->jRes(), signedDistance->kRes()))
+        , m_narrowBandWidth(narrowBandWidth)
+        , m_arena(arena)
     {
     }
 
@@ -33,13 +48,24 @@ public:
 
     virtual void track() override
     {
+        m_knownPoints = m_arena->checkOut<PredicateGridType>(m_signedDistance->res(), GridHalo(1));
+        m_closestSurfacePoints = m_arena->checkOut<FloatsThreeDVectorGridType>(m_signedDistance->res());
+
         determineBoundarySet();
 
         sweep();
         sweep();
+
+        m_knownPoints.reset();
+        m_closestSurfacePoints.reset();
+
+        pruneNarrowBand(*m_signedDistance, m_narrowBandWidth);
     }
 
 private:
+    typedef typename FloatsGridType::template Rebind<bool> PredicateGridType;
+    typedef typename FloatsGridType::template Rebind<FloatsThreeDVector> FloatsThreeDVectorGridType;
+
     static inline bool differentSigns(const FloatType left, const FloatType& right)
     {
         return left < 0 && right >= 0 || left >= 0 && right < 0;
@@ -56,21 +82,23 @@ private:
         const FloatType distanceToSurface = distance(closestSurfacePoint, i, j, k);
 
         FloatType& signedDistance = m_signedDistance->at(i, j, k);
-        bool& pointIsKnown = m_knownPoints->at(i, j, k);
+        const bool pointIsKnown = m_knownPoints->at(i, j, k);
 
-        if (pointIsKnown && (distanceToSurface < abs(signedDistance)) || !pointIsKnown)
+        if (pointIsKnown && (distanceToSurface < std::abs(signedDistance)) || !pointIsKnown)
         {
             m_closestSurfacePoints->at(i, j, k) = closestSurfacePoint;
             signedDistance = (signedDistance <= 0) ? -distanceToSurface : distanceToSurface;
-            pointIsKnown = true;
+            m_knownPoints->at(i, j, k) = true;
         }
     }
 
     void encloseSurface(const IntegerType ic, const IntegerType jc, const IntegerType kc,
         const IntegerType in, const IntegerType jn, const IntegerType kn)
     {
-        const FloatType& vc = m_signedDistance->at(ic, jc, kc);
-        const FloatType& vn = m_signedDistance->at(in, jn, kn);
+        const FloatsGridType& signedDistance = *m_signedDistance;
+
+        const FloatType vc = signedDistance.at(ic, jc, kc);
+        const FloatType vn = signedDistance.at(in, jn, kn);
 
         if (!differentSigns(vc, vn))
         {
@@ -86,73 +114,74 @@ private:
 
     void determineBoundarySet()
     {
+        const FloatsGridType& signedDistance = *m_signedDistance;
+
+        copyTopology(signedDistance, *m_knownPoints);
+        copyTopology(signedDistance, *m_closestSurfacePoints);
+
         setValues(m_knownPoints, false);
 
-        for (IntegerType i = 0; i < m_closestSurfacePoints->iRes() - 1; ++i)
+        forEachIndex(signedDistance, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
         {
-            for (IntegerType j = 0; j < m_closestSurfacePoints->jRes() - 1; ++j)
+            if (i < signedDistance.iRes() - 1 && j < signedDistance.jRes() - 1 && k < signedDistance.kRes() - 1)
             {
-                for (IntegerType k = 0; k < m_closestSurfacePoints->kRes() - 1; ++k)
-                {
-                    encloseSurface(i, j, k, i + 1, j, k);
-                    encloseSurface(i, j, k, i, j + 1, k);
-                    encloseSurface(i, j, k, i, j, k + 1);
-                }
+                encloseSurface(i, j, k, i + 1, j, k);
+                encloseSurface(i, j, k, i, j + 1, k);
+                encloseSurface(i, j, k, i, j, k + 1);
             }
-        }
+        });
     }
 
     void sweepFromNeighbour(const IntegerType ic, const IntegerType jc, const IntegerType kc,
         const IntegerType in, const IntegerType jn, const IntegerType kn)
     {
-        bool& neighbourIsKnown = m_knownPoints->at(in, jn, kn);
-        if (!neighbourIsKnown)
-        {
-            return;
-        }
+        const FloatsThreeDVectorGridType& closestSurfacePoints = *m_closestSurfacePoints;
 
-        const FloatsThreeDVector& neighbourClosestPoint = m_closestSurfacePoints->at(in, jn, kn);
+        const FloatsThreeDVector neighbourClosestPoint = closestSurfacePoints.at(in, jn, kn);
 
         trackPoint(neighbourClosestPoint, ic, jc, kc);
 
-        neighbourIsKnown = distance(neighbourClosestPoint, ic, jc, kc) >= abs(m_signedDistance->at(in, jn, kn));
+        m_knownPoints->at(in, jn, kn) = distance(neighbourClosestPoint, ic, jc, kc) >= std::abs(m_signedDistance->at(in, jn, kn));
     }
 
     void sweepPoint(const IntegerType i, const IntegerType j, const IntegerType k)
     {
-        if (m_knownPoints->at(i, j, k))
+        // Ghost cells of the known points grid are never known. A neighbour's bit only
+        // changes when the point sweeps from it, so the mask can be taken up front.
+
+        const std::uint32_t knownMask = stencilMask(*m_knownPoints, i, j, k);
+
+        if ((knownMask & stencilCenterBit) || !(knownMask & stencilNeighboursBits))
         {
             return;
         }
 
-        sweepFromNeighbour(i, j, k, i, j, k);
-
-        if (i > 0)
+        if (knownMask & stencilIMinusBit)
         {
             sweepFromNeighbour(i, j, k, i - 1, j, k);
         }
 
-        if (i < m_knownPoints->iRes() - 1)
+        if (knownMask & stencilIPlusBit)
         {
             sweepFromNeighbour(i, j, k, i + 1, j, k);
         }
 
-        if (j > 0)
+        if (knownMask & stencilJMinusBit)
         {
             sweepFromNeighbour(i, j, k, i, j - 1, k);
         }
 
-        if (j < m_knownPoints->jRes() - 1)
+        if (knownMask & stencilJPlusBit)
         {
             sweepFromNeighbour(i, j, k, i, j + 1, k);
         }
 
-        if (k > 0)
+        if (knownMask & stencilKMinusBit)
         {
             sweepFromNeighbour(i, j, k, i, j, k - 1);
         }
 
-        if (k < m_knownPoints->kRes() - 1)
+        if (knownMask & stencilKPlusBit)
         {
             sweepFromNeighbour(i, j, k, i, j, k + 1);
         }
@@ -160,101 +189,30 @@ private:
 
     void sweep()
     {
-        for (IntegerType i = 0; i < m_knownPoints->iRes(); ++i)
-        {
-            for (IntegerType j = 0; j < m_knownPoints->jRes(); ++j)
-            {
-                for (IntegerType k = 0; k < m_knownPoints->kRes(); ++k)
-                {
-                    sweepPoint(i, j, k);
-                }
-            }
-        }
-
-        for (IntegerType i = 0; i < m_knownPoints->iRes(); ++i)
-        {
-            for (IntegerType j = 0; j < m_knownPoints->jRes(); ++j)
-            {
-                for (IntegerType k = m_knownPoints->kRes() - 1; k >= 0; --k)
-                {
-                    sweepPoint(i, j, k);
-                }
-            }
-        }
-
-        for (IntegerType i = 0; i < m_knownPoints->iRes(); ++i)
-        {
-            for (IntegerType j = m_knownPoints->jRes() - 1; j >= 0; --j)
-            {
-                for (IntegerType k = 0; k < m_knownPoints->kRes(); ++k)
-                {
-                    sweepPoint(i, j, k);
-                }
-            }
-        }
-
-        for (IntegerType i = 0; i < m_knownPoints->iRes(); ++i)
-        {
-            for (IntegerType j = m_knownPoints->jRes() - 1; j >= 0; --j)
-            {
-                for (IntegerType k = m_knownPoints->kRes() - 1; k >= 0; --k)
-                {
-                    sweepPoint(i, j, k);
-                }
-            }
-        }
-
-        for (IntegerType i = m_knownPoints->iRes() - 1; i >= 0; --i)
-        {
-            for (IntegerType j = 0; j < m_knownPoints->jRes(); ++j)
-            {
-                for (IntegerType k = 0; k < m_knownPoints->kRes(); ++k)
-                {
-                    sweepPoint(i, j, k);
-                }
-            }
-        }
-
-        for (IntegerType i = m_knownPoints->iRes() - 1; i >= 0; --i)
-        {
-            for (IntegerType j = 0; j < m_knownPoints->jRes(); ++j)
-            {
-                for (IntegerType k = m_knownPoints->kRes() - 1; k >= 0; --k)
-                {
-                    sweepPoint(i, j, k);
-                }
-            }
-        }
-
-        for (IntegerType i = m_knownPoints->iRes() - 1; i >= 0; --i)
+        for (IntegerType direction = 0; direction < 8; ++direction)
         {
-            for (IntegerType j = m_knownPoints->jRes() - 1; j >= 0; --j)
-            {
-                for (IntegerType k = 0; k < m_knownPoints->kRes(); ++k)
-                {
-                    sweepPoint(i, j, k);
-                }
-            }
-        }
+            const bool iAscending = (direction & 4) == 0;
+            const bool jAscending = (direction & 2) == 0;
+            const bool kAscending = (direction & 1) == 0;
 
-        for (IntegerType i = m_knownPoints->iRes() - 1; i >= 0; --i)
-        {
-            for (IntegerType j = m_knownPoints->jRes() - 1; j >= 0; --j)
+            forEachIndexOrdered(*m_signedDistance, iAscending, jAscending, kAscending,
+                [this](const IntegerType i, const IntegerType j, const IntegerType k) -> void
             {
-                for (IntegerType k = m_knownPoints->kRes() - 1; k >= 0; --k)
-                {
-                    sweepPoint(i, j, k);
-                }
-            }
+                sweepPoint(i, j, k);
+            });
         }
     }
 
 private:
-    const FloatsGridPtr m_signedDistance;
+    const FloatsGridTypePtr m_signedDistance;
     const NearestSurfacePointCalculator<FloatsSpaceType> m_nearestSurfacePoint;
 
-    const PredicateGridPtr m_knownPoints;
-    const FloatsThreeDVectorGridPtr m_closestSurfacePoints;
+    const FloatType m_narrowBandWidth;
+
+    const GridArenaPtr m_arena;
+
+    std::shared_ptr<PredicateGridType> m_knownPoints;
+    std::shared_ptr<FloatsThreeDVectorGridType> m_closestSurfacePoints;
 };
 
 }
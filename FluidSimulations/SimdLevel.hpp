@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define FLUID_SIMULATIONS_X86_SIMD
+#include <intrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define FLUID_SIMULATIONS_X86_SIMD
+#include <cpuid.h>
+#endif
+
+namespace FluidSimulations
+{
+
+// Instruction sets of the explicitly vectorized loops. The loops use the highest level
+// which both the processor and the operating system support, limitSimdLevel lowers it,
+// for example to compare with the scalar loops. Dot products sum the vector lanes at the
+// end, so their last digits depend on the level, but not on the threads count.
+
+enum SimdLevel
+{
+    scalarSimdLevel,
+    sse42SimdLevel,
+    avx2SimdLevel,
+    avx512SimdLevel
+};
+
+inline SimdLevel detectSimdLevel()
+{
+#if defined(FLUID_SIMULATIONS_X86_SIMD)
+    unsigned int registers[4] = { 0, 0, 0, 0 };
+
+    const auto cpuid = [&registers](const unsigned int leaf, const unsigned int subleaf) -> bool
+    {
+#if defined(_MSC_VER)
+        int values[4];
+        __cpuid(values, 0);
+
+        if (static_cast<unsigned int>(values[0]) < leaf)
+        {
+            return false;
+        }
+
+        __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+        std::copy(values, values + 4, registers);
+
+        return true;
+#else
+        if (__get_cpuid_max(0, nullptr) < leaf)
+        {
+            return false;
+        }
+
+        __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+
+        return true;
+#endif
+    };
+
+    const auto xgetbv = []() -> unsigned long long
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        unsigned int low = 0;
+        unsigned int high = 0;
+
+        __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+
+        return (static_cast<unsigned long long>(high) << 32) | low;
+#endif
+    };
+
+    if (!cpuid(1, 0) || !(registers[2] & (1u << 20)))
+    {
+        return scalarSimdLevel;
+    }
+
+    const bool osSavesXmmAndYmm = (registers[2] & (1u << 27)) && (registers[2] & (1u << 28)) && (xgetbv() & 0x6) == 0x6;
+
+    if (!osSavesXmmAndYmm || !cpuid(7, 0) || !(registers[1] & (1u << 5)))
+    {
+        return sse42SimdLevel;
+    }
+
+    const bool osSavesZmm = (xgetbv() & 0xe6) == 0xe6;
+
+    if (!osSavesZmm || !(registers[1] & (1u << 16)))
+    {
+        return avx2SimdLevel;
+    }
+
+    return avx512SimdLevel;
+#else
+    return scalarSimdLevel;
+#endif
+}
+
+inline SimdLevel supportedSimdLevel()
+{
+    static const SimdLevel level = detectSimdLevel();
+
+    return level;
+}
+
+inline std::atomic<int>& simdLevelLimit()
+{
+    static std::atomic<int> limit(avx512SimdLevel);
+
+    return limit;
+}
+
+inline SimdLevel simdLevel()
+{
+    return static_cast<SimdLevel>(std::min<int>(supportedSimdLevel(), simdLevelLimit().load()));
+}
+
+inline void limitSimdLevel(const SimdLevel level)
+{
+    simdLevelLimit().store(level);
+}
+
+}
@@ -0,0 +1,428 @@
+#pragma once
+
+#include "GridHalo.hpp"
+#include "ScalarVectorDefinitions.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace FluidSimulations
+{
+
+// Sparse hierarchical grid: a root hash of nodes covering 128^3 cells each, every node
+// holds 16^3 slots, a slot is either a constant tile value or a dense 8^3 leaf. Cells
+// outside of all nodes, including the ones outside of the grid, have the background
+// value. The cells, leaves and tiles outside of the grid cannot be written.
+// Writing the cells of existing leaves does not change the tree, so it can be done
+// from several threads at once.
+
+template <typename ValueType>
+class SparseGrid
+{
+public:
+    static const IntegerType leafBits = 3;
+    static const IntegerType leafSize = 1 << leafBits;
+    static const IntegerType leafVolume = leafSize * leafSize * leafSize;
+
+    static const IntegerType nodeBits = 4;
+    static const IntegerType nodeSize = 1 << nodeBits;
+    static const IntegerType nodeVolume = nodeSize * nodeSize * nodeSize;
+
+    template <typename OtherValueType>
+    using Rebind = SparseGrid<OtherValueType>;
+
+    SparseGrid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes)
+        : SparseGrid(iRes, jRes, kRes, ValueType())
+    {
+    }
+
+    SparseGrid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const GridHalo&)
+        : SparseGrid(iRes, jRes, kRes)
+    {
+    }
+
+    SparseGrid(const IntegerType iRes, const IntegerType jRes, const IntegerType kRes,
+        const ValueType& background)
+        : m_iRes(iRes)
+        , m_jRes(jRes)
+        , m_kRes(kRes)
+        , m_jNodes(nodesCount(jRes))
+        , m_kNodes(nodesCount(kRes))
+        , m_background(background)
+    {
+    }
+
+    SparseGrid(const SparseGrid&) = delete;
+    SparseGrid& operator=(const SparseGrid&) = delete;
+
+    inline const IntegerType& iRes() const
+    {
+        return m_iRes;
+    }
+
+    inline const IntegerType& jRes() const
+    {
+        return m_jRes;
+    }
+
+    inline const IntegerType& kRes() const
+    {
+        return m_kRes;
+    }
+
+    inline IntegersThreeDVector res() const
+    {
+        return IntegersThreeDVector(iRes(), jRes(), kRes());
+    }
+
+    inline const ValueType& background() const
+    {
+        return m_background;
+    }
+
+    inline IntegerType leavesCount() const
+    {
+        IntegerType count = 0;
+
+        for (const auto& node : m_root)
+        {
+            count += node.second->leavesCount;
+        }
+
+        return count;
+    }
+
+    inline const ValueType& at(const IntegerType i, const IntegerType j, const IntegerType k) const
+    {
+        if (!contains(i, j, k))
+        {
+            return m_background;
+        }
+
+        const auto node = m_root.find(nodeKey(i, j, k));
+
+        if (node == m_root.end())
+        {
+            return m_background;
+        }
+
+        const IntegerType slot = slotIndex(i, j, k);
+        const Leaf* const leaf = node->second->leaves[slot].get();
+
+        return leaf ? leaf->values[cellIndex(i, j, k)] : node->second->tiles[slot];
+    }
+
+    inline ValueType& at(const IntegerType i, const IntegerType j, const IntegerType k)
+    {
+        assert(contains(i, j, k));
+
+        const auto node = m_root.find(nodeKey(i, j, k));
+
+        if (node != m_root.end())
+        {
+            Leaf* const leaf = node->second->leaves[slotIndex(i, j, k)].get();
+
+            if (leaf)
+            {
+                return leaf->values[cellIndex(i, j, k)];
+            }
+        }
+
+        return touchLeaf(i, j, k).values[cellIndex(i, j, k)];
+    }
+
+    inline bool hasLeaf(const IntegerType i, const IntegerType j, const IntegerType k) const
+    {
+        if (!contains(i, j, k))
+        {
+            return false;
+        }
+
+        const auto node = m_root.find(nodeKey(i, j, k));
+
+        return node != m_root.end() && node->second->leaves[slotIndex(i, j, k)];
+    }
+
+    inline void activateLeaf(const IntegerType i, const IntegerType j, const IntegerType k)
+    {
+        assert(contains(i, j, k));
+
+        touchLeaf(i, j, k);
+    }
+
+    void setTile(const IntegerType i, const IntegerType j, const IntegerType k, const ValueType& tileValue)
+    {
+        assert(contains(i, j, k));
+
+        Node& node = touchNode(i, j, k);
+
+        const IntegerType slot = slotIndex(i, j, k);
+
+        if (node.leaves[slot])
+        {
+            node.leaves[slot].reset();
+            --node.leavesCount;
+        }
+
+        node.tiles[slot] = tileValue;
+    }
+
+    std::vector<IntegersThreeDVector> leafOrigins() const
+    {
+        std::vector<IntegersThreeDVector> origins;
+
+        for (const auto& node : m_root)
+        {
+            for (IntegerType slot = 0; slot != nodeVolume; ++slot)
+            {
+                if (node.second->leaves[slot])
+                {
+                    origins.push_back(slotOrigin(node.second->origin, slot));
+                }
+            }
+        }
+
+        return origins;
+    }
+
+    void fill(const ValueType& value)
+    {
+        m_background = value;
+
+        for (auto& node : m_root)
+        {
+            std::fill(node.second->tiles, node.second->tiles + nodeVolume, value);
+
+            for (IntegerType slot = 0; slot != nodeVolume; ++slot)
+            {
+                if (node.second->leaves[slot])
+                {
+                    std::fill(node.second->leaves[slot]->values, node.second->leaves[slot]->values + leafVolume, value);
+                }
+            }
+        }
+    }
+
+    template <typename OtherValueType>
+    void copyTopology(const SparseGrid<OtherValueType>& source)
+    {
+        for (auto& node : m_root)
+        {
+            for (IntegerType slot = 0; slot != nodeVolume; ++slot)
+            {
+                const IntegersThreeDVector origin = slotOrigin(node.second->origin, slot);
+
+                if (node.second->leaves[slot] && !source.hasLeaf(origin.x, origin.y, origin.z))
+                {
+                    node.second->leaves[slot].reset();
+                    --node.second->leavesCount;
+                }
+            }
+        }
+
+        const std::vector<IntegersThreeDVector> origins = source.leafOrigins();
+
+        for (const IntegersThreeDVector& origin : origins)
+        {
+            activateLeaf(origin.x, origin.y, origin.z);
+        }
+    }
+
+    void copyTopology(const SparseGrid& source)
+    {
+        m_background = source.m_background;
+
+        for (auto& node : m_root)
+        {
+            if (source.m_root.find(node.first) == source.m_root.end())
+            {
+                std::fill(node.second->tiles, node.second->tiles + nodeVolume, m_background);
+            }
+        }
+
+        for (const auto& sourceNode : source.m_root)
+        {
+            std::unique_ptr<Node>& node = m_root[sourceNode.first];
+
+            if (!node)
+            {
+                node.reset(new Node(sourceNode.second->origin, m_background));
+            }
+
+            std::copy(sourceNode.second->tiles, sourceNode.second->tiles + nodeVolume, node->tiles);
+        }
+
+        copyTopology<ValueType>(source);
+    }
+
+    void dilate()
+    {
+        const std::vector<IntegersThreeDVector> origins = leafOrigins();
+
+        for (const IntegersThreeDVector& origin : origins)
+        {
+            for (IntegerType i = origin.x - leafSize; i <= origin.x + leafSize; i += leafSize)
+            {
+                for (IntegerType j = origin.y - leafSize; j <= origin.y + leafSize; j += leafSize)
+                {
+                    for (IntegerType k = origin.z - leafSize; k <= origin.z + leafSize; k += leafSize)
+                    {
+                        if (contains(i, j, k))
+                        {
+                            activateLeaf(i, j, k);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void swap(SparseGrid& other)
+    {
+        assert(m_iRes == other.m_iRes && m_jRes == other.m_jRes && m_kRes == other.m_kRes);
+
+        std::swap(m_background, other.m_background);
+        m_root.swap(other.m_root);
+    }
+
+    void copyIn(const SparseGrid& source)
+    {
+        m_root.clear();
+        m_background = source.m_background;
+
+        for (const auto& sourceNode : source.m_root)
+        {
+            std::unique_ptr<Node> node(new Node(sourceNode.second->origin, m_background));
+
+            std::copy(sourceNode.second->tiles, sourceNode.second->tiles + nodeVolume, node->tiles);
+
+            for (IntegerType slot = 0; slot != nodeVolume; ++slot)
+            {
+                if (sourceNode.second->leaves[slot])
+                {
+                    node->leaves[slot].reset(new Leaf(*sourceNode.second->leaves[slot]));
+                }
+            }
+
+            node->leavesCount = sourceNode.second->leavesCount;
+
+            m_root[sourceNode.first] = std::move(node);
+        }
+    }
+
+private:
+    struct Leaf
+    {
+        explicit Leaf(const ValueType& value)
+        {
+            std::fill(values, values + leafVolume, value);
+        }
+
+        ValueType values[leafVolume];
+    };
+
+    struct Node
+    {
+        Node(const IntegersThreeDVector& nodeOrigin, const ValueType& background)
+            : origin(nodeOrigin)
+            , leavesCount(0)
+        {
+            std::fill(tiles, tiles + nodeVolume, background);
+        }
+
+        const IntegersThreeDVector origin;
+        IntegerType leavesCount;
+        ValueType tiles[nodeVolume];
+        std::unique_ptr<Leaf> leaves[nodeVolume];
+    };
+
+    // nodeKey folds the indices of the cells outside of the grid into the keys of other
+    // nodes, so they have to be checked before any lookup.
+
+    inline bool contains(const IntegerType i, const IntegerType j, const IntegerType k) const
+    {
+        return i >= 0 && i < m_iRes && j >= 0 && j < m_jRes && k >= 0 && k < m_kRes;
+    }
+
+    static inline IntegerType nodesCount(const IntegerType res)
+    {
+        return (res + (1 << (nodeBits + leafBits)) - 1) >> (nodeBits + leafBits);
+    }
+
+    inline IntegerType nodeKey(const IntegerType i, const IntegerType j, const IntegerType k) const
+    {
+        constexpr IntegerType shift = nodeBits + leafBits;
+
+        return ((i >> shift) * m_jNodes + (j >> shift)) * m_kNodes + (k >> shift);
+    }
+
+    static inline IntegerType slotIndex(const IntegerType i, const IntegerType j, const IntegerType k)
+    {
+        constexpr IntegerType mask = nodeSize - 1;
+
+        return ((((i >> leafBits) & mask) << nodeBits | ((j >> leafBits) & mask)) << nodeBits) | ((k >> leafBits) & mask);
+    }
+
+    static inline IntegerType cellIndex(const IntegerType i, const IntegerType j, const IntegerType k)
+    {
+        constexpr IntegerType mask = leafSize - 1;
+
+        return (((i & mask) << leafBits | (j & mask)) << leafBits) | (k & mask);
+    }
+
+    static inline IntegersThreeDVector slotOrigin(const IntegersThreeDVector& nodeOrigin, const IntegerType slot)
+    {
+        return IntegersThreeDVector(
+            nodeOrigin.x + ((slot >> (2 * nodeBits)) << leafBits),
+            nodeOrigin.y + (((slot >> nodeBits) & (nodeSize - 1)) << leafBits),
+            nodeOrigin.z + ((slot & (nodeSize - 1)) << leafBits));
+    }
+
+    Node& touchNode(const IntegerType i, const IntegerType j, const IntegerType k)
+    {
+        std::unique_ptr<Node>& node = m_root[nodeKey(i, j, k)];
+
+        if (!node)
+        {
+            constexpr IntegerType mask = ~((1 << (nodeBits + leafBits)) - 1);
+
+            node.reset(new Node(IntegersThreeDVector(i & mask, j & mask, k & mask), m_background));
+        }
+
+        return *node;
+    }
+
+    Leaf& touchLeaf(const IntegerType i, const IntegerType j, const IntegerType k)
+    {
+        Node& node = touchNode(i, j, k);
+
+        const IntegerType slot = slotIndex(i, j, k);
+        std::unique_ptr<Leaf>& leaf = node.leaves[slot];
+
+        if (!leaf)
+        {
+            leaf.reset(new Leaf(node.tiles[slot]));
+            ++node.leavesCount;
+        }
+
+        return *leaf;
+    }
+
+private:
+    const IntegerType m_iRes;
+    const IntegerType m_jRes;
+    const IntegerType m_kRes;
+
+    const IntegerType m_jNodes;
+    const IntegerType m_kNodes;
+
+    ValueType m_background;
+
+    std::unordered_map<IntegerType, std::unique_ptr<Node>> m_root;
+};
+
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include "ScalarTypes.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FluidSimulations
+{
+
+// Work stealing scheduler: every worker takes tasks from the back of its own queue and
+// steals from the front of the others when it runs dry. A thread which waits for a
+// parallel loop runs the pending tasks itself, so loops can be nested. A scheduler of
+// one thread has no workers and runs everything on the calling thread.
+//
+// Ranges are split into chunks of the given grain whatever the threads count is, and
+// parallelReduce combines the chunk results in the order of the chunks, so results
+// do not depend on the threads count.
+
+class TaskScheduler
+{
+public:
+    explicit TaskScheduler(const IntegerType threadsCount = defaultThreadsCount())
+        : m_queues(std::max<IntegerType>(threadsCount - 1, 0))
+        , m_pendingTasks(0)
+        , m_nextQueue(0)
+        , m_stopping(false)
+    {
+        for (std::size_t index = 0; index != m_queues.size(); ++index)
+        {
+            m_queues[index].reset(new Queue());
+        }
+
+        for (std::size_t index = 0; index != m_queues.size(); ++index)
+        {
+            m_workers.push_back(std::thread(&TaskScheduler::work, this, index));
+        }
+    }
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    ~TaskScheduler()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_stopping = true;
+        }
+
+        m_wakeCondition.notify_all();
+
+        for (std::thread& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    static inline IntegerType defaultThreadsCount()
+    {
+        return std::max<IntegerType>(static_cast<IntegerType>(std::thread::hardware_concurrency()), 1);
+    }
+
+    inline IntegerType threadsCount() const
+    {
+        return static_cast<IntegerType>(m_workers.size()) + 1;
+    }
+
+    // Calls functor(chunkBegin, chunkEnd) for the chunks of [begin, end).
+
+    template <typename FunctorType>
+    void parallelFor(const IntegerType begin, const IntegerType end, const IntegerType grain, FunctorType functor)
+    {
+        const IntegerType chunksCount = (end - begin + grain - 1) / grain;
+
+        if (chunksCount <= 1 || m_workers.empty())
+        {
+            for (IntegerType chunkBegin = begin; chunkBegin < end; chunkBegin += grain)
+            {
+                functor(chunkBegin, std::min(chunkBegin + grain, end));
+            }
+
+            return;
+        }
+
+        std::atomic<IntegerType> remainingChunks(chunksCount);
+
+        for (IntegerType chunk = 0; chunk != chunksCount; ++chunk)
+        {
+            const IntegerType chunkBegin = begin + chunk * grain;
+            const IntegerType chunkEnd = std::min(chunkBegin + grain, end);
+
+            push([&functor, &remainingChunks, chunkBegin, chunkEnd]() -> void
+            {
+                functor(chunkBegin, chunkEnd);
+                --remainingChunks;
+            });
+        }
+
+        while (remainingChunks != 0)
+        {
+            Task task;
+
+            if (steal(0, task))
+            {
+                task();
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Combines the results of map(chunkBegin, chunkEnd) for the chunks of [begin, end),
+    // from the first chunk to the last one.
+
+    template <typename ValueType, typename MapType, typename CombineType>
+    ValueType parallelReduce(const IntegerType begin, const IntegerType end, const IntegerType grain,
+        const ValueType& identity, MapType map, CombineType combine)
+    {
+        const IntegerType chunksCount = (end - begin + grain - 1) / grain;
+
+        std::vector<ValueType> partials(std::max<IntegerType>(chunksCount, 0), identity);
+
+        parallelFor(begin, end, grain, [&](const IntegerType chunkBegin, const IntegerType chunkEnd) -> void
+        {
+            partials[(chunkBegin - begin) / grain] = map(chunkBegin, chunkEnd);
+        });
+
+        ValueType result = identity;
+
+        for (const ValueType& partial : partials)
+        {
+            result = combine(result, partial);
+        }
+
+        return result;
+    }
+
+private:
+    typedef std::function<void()> Task;
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void push(Task task)
+    {
+        Queue& queue = *m_queues[m_nextQueue++ % m_queues.size()];
+
+        {
+            const std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+
+        ++m_pendingTasks;
+
+        {
+            const std::lock_guard<std::mutex> lock(m_wakeMutex);
+        }
+
+        m_wakeCondition.notify_one();
+    }
+
+    bool popOwn(const std::size_t index, Task& task)
+    {
+        Queue& queue = *m_queues[index];
+        const std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.tasks.empty())
+        {
+            return false;
+        }
+
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        --m_pendingTasks;
+
+        return true;
+    }
+
+    bool steal(const std::size_t firstIndex, Task& task)
+    {
+        for (std::size_t offset = 0; offset != m_queues.size(); ++offset)
+        {
+            Queue& queue = *m_queues[(firstIndex + offset) % m_queues.size()];
+            const std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if (!queue.tasks.empty())
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                --m_pendingTasks;
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void work(const std::size_t index)
+    {
+        for (;;)
+        {
+            Task task;
+
+            if (popOwn(index, task) || steal(index + 1, task))
+            {
+                task();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+
+            m_wakeCondition.wait(lock, [this]() -> bool
+            {
+                return m_stopping || m_pendingTasks != 0;
+            });
+
+            if (m_stopping)
+            {
+                return;
+            }
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::atomic<IntegerType> m_pendingTasks;
+    std::atomic<std::size_t> m_nextQueue;
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+    bool m_stopping;
+};
+
+typedef std::shared_ptr<TaskScheduler> TaskSchedulerPtr;
+
+}
@@ -0,0 +1,100 @@
+#include "AquariumFluidSystem.hpp"
+#include "SdfFunctions.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace FluidSimulationsBenchmark
+{
+
+namespace
+{
+
+const float c_gravitation = 0.196f;
+
+const int c_framRate = 25;
+
+const int c_defaultStepsCount = 5;
+
+double seconds(const std::chrono::steady_clock::duration& duration)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+}
+
+void benchmarkWaterBall(const int resolution, const int stepsCount)
+{
+    using FluidSimulations::FloatType;
+
+    const FloatType halfRes = resolution * 0.5f;
+
+    const FluidSimulations::FloatsThreeDVector center(halfRes, halfRes, halfRes);
+    const FloatType radius = resolution * 0.2f;
+
+    const auto buildStart = std::chrono::steady_clock::now();
+
+    const std::shared_ptr<FluidSimulationsDemo::AquariumFluidSystem> fluidSystem = FluidSimulationsDemo::AquariumFluidSystem::build(
+        resolution, resolution, resolution, c_gravitation * resolution, FluidSimulationsDemo::waterBallSdf(center, radius), 1.0f / c_framRate);
+
+    const FluidSimulations::Machinery::StepTimeBudgetPtr stepBudget = fluidSystem->stepBudget();
+
+    FloatType maxDivergence = 0;
+
+    const auto stepsStart = std::chrono::steady_clock::now();
+
+    for (int step = 0; step != stepsCount; ++step)
+    {
+        fluidSystem->simulator()->step();
+
+        if (stepBudget)
+        {
+            maxDivergence = std::max(maxDivergence, stepBudget->divergence());
+        }
+    }
+
+    const auto stepsEnd = std::chrono::steady_clock::now();
+
+    std::cout << "FloatType: " << sizeof(FloatType) * 8 << " bits"
+        << ", resolution: " << resolution << "^3"
+        << ", build: " << seconds(stepsStart - buildStart) << " s"
+        << ", step: " << seconds(stepsEnd - stepsStart) / stepsCount << " s"
+        << ", sdf(center): " << fluidSystem->fluidSdf().at(halfRes, halfRes, halfRes);
+
+    if (stepBudget)
+    {
+        std::cout << ", max divergence: " << maxDivergence;
+    }
+
+    std::cout << std::endl;
+}
+
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const int stepsCount = argc > 1 ? std::atoi(argv[1]) : FluidSimulationsBenchmark::c_defaultStepsCount;
+
+    std::vector<int> resolutions;
+
+    for (int argument = 2; argument < argc; ++argument)
+    {
+        resolutions.push_back(std::atoi(argv[argument]));
+    }
+
+    if (resolutions.empty())
+    {
+        resolutions.push_back(128);
+        resolutions.push_back(256);
+    }
+
+    for (const int resolution : resolutions)
+    {
+        FluidSimulationsBenchmark::benchmarkWaterBall(resolution, std::max(stepsCount, 1));
+    }
+
+    return 0;
+}
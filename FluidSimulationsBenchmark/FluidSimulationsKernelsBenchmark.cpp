@@ -0,0 +1,209 @@
+#include <FluidSimulations\FluidSimulations.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace FluidSimulationsBenchmark
+{
+
+namespace
+{
+
+const int c_defaultIterationsCount = 50;
+const unsigned int c_seed = 1;
+
+const float c_fluidHeight = 0.6f;
+
+const FluidSimulations::FloatType c_fluidDensity = 1000;
+const FluidSimulations::FloatType c_timeInterval = 0.04f;
+const FluidSimulations::FloatType c_step = 0.001f;
+
+typedef FluidSimulations::Projection::MiccgZeroKernel
+<
+    FluidSimulations::FloatType, FluidSimulations::FloatType, FluidSimulations::CellFlagsPredicate
+>
+KernelType;
+
+double seconds(const std::chrono::steady_clock::duration& duration)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+}
+
+FluidSimulations::FloatsGridPtr randomGrid(const int resolution, const FluidSimulations::CellFlagsPredicate& fluidPredicate)
+{
+    using namespace FluidSimulations;
+
+    const FloatsGridPtr grid = std::make_shared<FloatsGrid>(resolution, resolution, resolution, GridHalo(1));
+
+    forEachIndex(*grid, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+    {
+        grid->at(i, j, k) = fluidPredicate.at(i, j, k) ? std::rand() / static_cast<FloatType>(RAND_MAX) - 0.5f : 0;
+    });
+
+    return grid;
+}
+
+const char* simdLevelName(const FluidSimulations::SimdLevel level)
+{
+    using namespace FluidSimulations;
+
+    switch (level)
+    {
+    case sse42SimdLevel:
+        return "SSE4.2";
+    case avx2SimdLevel:
+        return "AVX2";
+    case avx512SimdLevel:
+        return "AVX-512";
+    default:
+        return "scalar";
+    }
+}
+
+template <typename FunctorType>
+double millisecondsPerIteration(const int iterationsCount, FunctorType functor)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int iteration = 0; iteration != iterationsCount; ++iteration)
+    {
+        functor();
+    }
+
+    return 1000 * seconds(std::chrono::steady_clock::now() - start) / iterationsCount;
+}
+
+// Times the part of a conjugate gradient iteration between two preconditioner applications
+// over a tank filled to c_fluidHeight, as separate passes over the active cells and fused,
+// and the passes themselves, for the instruction sets up to the supported one.
+
+void benchmarkIteration(const int resolution, const int iterationsCount)
+{
+    using namespace FluidSimulations;
+
+    const CellFlagsGridPtr cellFlags = std::make_shared<CellFlagsGrid>(resolution, resolution, resolution, GridHalo(1));
+    setValues(cellFlags, solidCellFlag);
+
+    forEachIndex(*cellFlags, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+    {
+        cellFlags->at(i, j, k) = j < c_fluidHeight * resolution ? fluidCellFlag : 0;
+    });
+
+    const CellFlagsPredicate fluidPredicate = CellFlagsPredicate::fluid(cellFlags);
+
+    const MacVelocityGridPtr velocity = std::make_shared<MacVelocityGrid>(resolution, resolution, resolution);
+    const FloatsFourDVectorGridPtr coefficients = std::make_shared<FloatsFourDVectorGrid>(resolution, resolution, resolution, GridHalo(1));
+    const FloatsGridPtr rhs = std::make_shared<FloatsGrid>(resolution, resolution, resolution);
+
+    Projection::GridAllignedPressureSolvePreparator
+    <
+        CellFlagsPredicate, CellFlagsPredicate, CellFlagsPredicate, ConstantSpace<FloatsThreeDVector>
+    >
+    preparator(cellFlags->res(), velocity, fluidPredicate, CellFlagsPredicate::solid(cellFlags), CellFlagsPredicate::air(cellFlags),
+        ConstantSpace<FloatsThreeDVector>(FloatsThreeDVector(0, 0, 0)), c_fluidDensity, coefficients, rhs);
+
+    preparator.prepare(c_timeInterval);
+
+    const Projection::PressureStencilGridPtr stencils = std::make_shared<Projection::PressureStencilGrid>(resolution, resolution, resolution);
+
+    Projection::GridAllignedPressureSolvePreparator
+    <
+        CellFlagsPredicate, CellFlagsPredicate, CellFlagsPredicate, ConstantSpace<FloatsThreeDVector>, Projection::PressureStencilGrid
+    >
+    stencilPreparator(cellFlags->res(), velocity, fluidPredicate, CellFlagsPredicate::solid(cellFlags), CellFlagsPredicate::air(cellFlags),
+        ConstantSpace<FloatsThreeDVector>(FloatsThreeDVector(0, 0, 0)), c_fluidDensity, stencils, rhs);
+
+    stencilPreparator.prepare(c_timeInterval);
+
+    TaskScheduler scheduler;
+
+    const Projection::ActiveCellsList activeCells(scheduler, cellFlags->res(), fluidPredicate);
+
+    for (int level = scalarSimdLevel; level <= supportedSimdLevel(); ++level)
+    {
+        limitSimdLevel(static_cast<SimdLevel>(level));
+
+        std::srand(c_seed);
+
+        const FloatsGridPtr solution = randomGrid(resolution, fluidPredicate);
+        const FloatsGridPtr residual = randomGrid(resolution, fluidPredicate);
+        const FloatsGridPtr search = randomGrid(resolution, fluidPredicate);
+        const FloatsGridPtr auxiliary = randomGrid(resolution, fluidPredicate);
+
+        FloatType checksum = 0;
+
+        const double separate = millisecondsPerIteration(iterationsCount, [&]() -> void
+        {
+            KernelType::applyMatrix(scheduler, *auxiliary, *coefficients, *search, activeCells);
+            checksum += KernelType::multiply(scheduler, *auxiliary, *search, activeCells);
+
+            KernelType::sumIn(scheduler, *solution, 1, *solution, c_step, *search, activeCells);
+            KernelType::sumIn(scheduler, *residual, 1, *residual, -c_step, *auxiliary, activeCells);
+            checksum += KernelType::calculateStopRate(scheduler, *residual, activeCells);
+        });
+
+        const double fused = millisecondsPerIteration(iterationsCount, [&]() -> void
+        {
+            checksum += KernelType::applyMatrixAndMultiply(scheduler, *auxiliary, *coefficients, *search, activeCells);
+            checksum += KernelType::updateSolutionAndResidual(scheduler, *solution, *residual, c_step, *search, *auxiliary, activeCells);
+        });
+
+        const double multiply = millisecondsPerIteration(iterationsCount, [&]() -> void
+        {
+            checksum += KernelType::multiply(scheduler, *auxiliary, *search, activeCells);
+        });
+
+        const double sumIn = millisecondsPerIteration(iterationsCount, [&]() -> void
+        {
+            KernelType::sumIn(scheduler, *search, 1, *auxiliary, c_step, *search, activeCells);
+        });
+
+        const double stencilProduct = millisecondsPerIteration(iterationsCount, [&]() -> void
+        {
+            checksum += KernelType::applyMatrixAndMultiply(scheduler, *auxiliary, *stencils, *search, activeCells);
+        });
+
+        std::cout << "FloatType: " << sizeof(FloatType) * 8 << " bits"
+            << ", resolution: " << resolution << "^3"
+            << ", active cells: " << activeCells.size()
+            << ", instructions: " << simdLevelName(static_cast<SimdLevel>(level))
+            << ", separate (5 passes): " << separate << " ms"
+            << ", fused (2 passes): " << fused << " ms"
+            << ", multiply: " << multiply << " ms"
+            << ", sumIn: " << sumIn << " ms"
+            << ", stencil product: " << stencilProduct << " ms"
+            << ", checksum: " << checksum << std::endl;
+    }
+}
+
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const int iterationsCount = argc > 1 ? std::atoi(argv[1]) : FluidSimulationsBenchmark::c_defaultIterationsCount;
+
+    std::vector<int> resolutions;
+
+    for (int argument = 2; argument < argc; ++argument)
+    {
+        resolutions.push_back(std::atoi(argv[argument]));
+    }
+
+    if (resolutions.empty())
+    {
+        resolutions.push_back(128);
+        resolutions.push_back(256);
+    }
+
+    for (const int resolution : resolutions)
+    {
+        FluidSimulationsBenchmark::benchmarkIteration(resolution, std::max(iterationsCount, 1));
+    }
+
+    return 0;
+}
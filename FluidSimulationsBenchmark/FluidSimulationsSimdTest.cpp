@@ -0,0 +1,184 @@
+#include <FluidSimulations\FluidSimulations.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace FluidSimulationsBenchmark
+{
+
+namespace
+{
+
+const int c_resolution = 37;
+const unsigned int c_seed = 1;
+
+const double c_step = 0.01;
+
+// The passes of MiccgZeroKernel with each instruction set the processor supports have
+// to give the results of the scalar loops up to the rounding: the dot products sum the
+// vector lanes at the end and the compiler may fuse the multiplications and additions.
+// The fluid cells are random, so the runs have all lengths and end in the scalar tails.
+
+double random(const double min, const double max)
+{
+    return min + (max - min) * std::rand() / RAND_MAX;
+}
+
+struct PassesResults
+{
+    std::vector<double> values;
+    std::vector<double> reductions;
+};
+
+template <typename GridType>
+void appendValues(std::vector<double>& values, const GridType& grid)
+{
+    using namespace FluidSimulations;
+
+    forEachIndex(grid, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+    {
+        values.push_back(static_cast<double>(grid.at(i, j, k)));
+    });
+}
+
+template <typename ScalarType, typename AccumulatorType>
+PassesResults runPasses(const FluidSimulations::SimdLevel level)
+{
+    using namespace FluidSimulations;
+
+    typedef Projection::MiccgZeroKernel<ScalarType, AccumulatorType, CellFlagsPredicate> KernelType;
+    typedef typename KernelType::ScalarsGrid ScalarsGrid;
+    typedef typename KernelType::CoefficientsGrid CoefficientsGrid;
+
+    limitSimdLevel(level);
+
+    std::srand(c_seed);
+
+    const CellFlagsGridPtr cellFlags = std::make_shared<CellFlagsGrid>(c_resolution, c_resolution, c_resolution, GridHalo(1));
+    setValues(cellFlags, solidCellFlag);
+
+    forEachIndex(*cellFlags, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+    {
+        cellFlags->at(i, j, k) = std::rand() % 4 != 0 ? fluidCellFlag : 0;
+    });
+
+    const CellFlagsPredicate fluidPredicate = CellFlagsPredicate::fluid(cellFlags);
+
+    CoefficientsGrid coefficients(c_resolution, c_resolution, c_resolution, GridHalo(1), ScalarFourdDVector<ScalarType>());
+    Projection::PressureStencilGrid stencils(c_resolution, c_resolution, c_resolution);
+
+    stencils.setScale(static_cast<FloatType>(random(0.5, 1)));
+
+    ScalarsGrid source(c_resolution, c_resolution, c_resolution, GridHalo(1), 0);
+    ScalarsGrid solution(c_resolution, c_resolution, c_resolution, GridHalo(1), 0);
+    ScalarsGrid residual(c_resolution, c_resolution, c_resolution, GridHalo(1), 0);
+    ScalarsGrid product(c_resolution, c_resolution, c_resolution, GridHalo(1), 0);
+    ScalarsGrid stencilsProduct(c_resolution, c_resolution, c_resolution, GridHalo(1), 0);
+    ScalarsGrid sum(c_resolution, c_resolution, c_resolution, GridHalo(1), 0);
+
+    forEachIndex(*cellFlags, [&](const IntegerType i, const IntegerType j, const IntegerType k) -> void
+    {
+        if (!fluidPredicate.at(i, j, k))
+        {
+            return;
+        }
+
+        coefficients.at(i, j, k) = ScalarFourdDVector<ScalarType>(static_cast<ScalarType>(random(6, 7)),
+            static_cast<ScalarType>(random(-1, 0)), static_cast<ScalarType>(random(-1, 0)), static_cast<ScalarType>(random(-1, 0)));
+
+        stencils.stencils().at(i, j, k) = static_cast<Projection::PressureStencil>((std::rand() % 7) << Projection::PressureStencilGrid::diagonalShift);
+
+        source.at(i, j, k) = static_cast<ScalarType>(random(-0.5, 0.5));
+        solution.at(i, j, k) = static_cast<ScalarType>(random(-0.5, 0.5));
+        residual.at(i, j, k) = static_cast<ScalarType>(random(-0.5, 0.5));
+    });
+
+    TaskScheduler scheduler;
+
+    const Projection::ActiveCellsList activeCells(scheduler, cellFlags->res(), fluidPredicate);
+
+    PassesResults results;
+
+    results.reductions.push_back(KernelType::applyMatrixAndMultiply(scheduler, product, coefficients, source, activeCells));
+    results.reductions.push_back(KernelType::applyMatrixAndMultiply(scheduler, stencilsProduct, stencils, source, activeCells));
+    results.reductions.push_back(KernelType::multiply(scheduler, source, product, activeCells));
+    results.reductions.push_back(KernelType::updateSolutionAndResidual(scheduler, solution, residual,
+        static_cast<ScalarType>(c_step), source, product, activeCells));
+    results.reductions.push_back(KernelType::calculateStopRate(scheduler, residual, activeCells));
+
+    KernelType::sumIn(scheduler, sum, 1, solution, static_cast<ScalarType>(c_step), stencilsProduct, activeCells);
+
+    appendValues(results.values, product);
+    appendValues(results.values, stencilsProduct);
+    appendValues(results.values, solution);
+    appendValues(results.values, residual);
+    appendValues(results.values, sum);
+
+    return results;
+}
+
+double relativeDifference(const std::vector<double>& values, const std::vector<double>& expectedValues)
+{
+    double result = 0;
+
+    for (std::size_t index = 0; index != values.size(); ++index)
+    {
+        const double difference = std::abs(values[index] - expectedValues[index]) / std::max(1.0, std::abs(expectedValues[index]));
+
+        result = std::max(result, difference);
+    }
+
+    return result;
+}
+
+template <typename ScalarType, typename AccumulatorType>
+bool checkLevels(const char* kernelName)
+{
+    using namespace FluidSimulations;
+
+    const double tolerance = 1000 * std::numeric_limits<ScalarType>::epsilon();
+
+    const PassesResults expected = runPasses<ScalarType, AccumulatorType>(scalarSimdLevel);
+
+    bool agree = true;
+
+    for (int level = sse42SimdLevel; level <= supportedSimdLevel(); ++level)
+    {
+        const PassesResults results = runPasses<ScalarType, AccumulatorType>(static_cast<SimdLevel>(level));
+
+        const double valuesDifference = relativeDifference(results.values, expected.values);
+        const double reductionsDifference = relativeDifference(results.reductions, expected.reductions);
+
+        const bool levelAgrees = valuesDifference <= tolerance && reductionsDifference <= tolerance;
+
+        std::cout << kernelName << ", level " << level
+            << ", values difference: " << valuesDifference
+            << ", reductions difference: " << reductionsDifference
+            << (levelAgrees ? ", agree" : ", DIFFER") << std::endl;
+
+        agree = agree && levelAgrees;
+    }
+
+    limitSimdLevel(avx512SimdLevel);
+
+    return agree;
+}
+
+}
+
+}
+
+int main()
+{
+    using namespace FluidSimulationsBenchmark;
+
+    bool agree = checkLevels<float, float>("float");
+    agree = checkLevels<double, double>("double") && agree;
+    agree = checkLevels<float, double>("float, double accumulator") && agree;
+
+    return agree ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,5 +1,9 @@
 #include "AquariumFluidSystem.hpp"
 
+#ifdef FLUID_SIMULATIONS_DEMO_EIGEN_SOLVER
+#include <FluidSimulations\Projection\EigenPressureSolver.hpp>
+#endif
+
 #include <algorithm>
 
 using FluidSimulations::FloatType;
@@ -12,10 +16,27 @@ namespace FluidSimulationsDemo
 namespace
 {
 
-FluidSimulations::FloatsGridPtr buildGrid(const int iRes, const int jRes, const int kRes,
+const FloatType narrowBandWidth = 4.0f;
+
+const double previewStepSeconds = 1.0 / 30;
+
+#ifdef FLUID_SIMULATIONS_DEMO_SPARSE_SDF
+FluidSdfGridPtr buildGrid(const int iRes, const int jRes, const int kRes,
     const FloatSpaceFunctor& sdf)
 {
-    FluidSimulations::FloatsGridPtr targetGrid = std::make_shared<FluidSimulations::Grid<FloatType>>(iRes, jRes, kRes);
+    const FloatType background = 4.0f * narrowBandWidth;
+
+    FluidSdfGridPtr targetGrid = std::make_shared<FluidSimulations::SparseFloatsGrid>(iRes, jRes, kRes, background);
+
+    FluidSimulations::SignedDistanceField::buildNarrowBand(*targetGrid, narrowBandWidth, sdf);
+
+    return targetGrid;
+}
+#else
+FluidSdfGridPtr buildGrid(const int iRes, const int jRes, const int kRes,
+    const FloatSpaceFunctor& sdf)
+{
+    FluidSdfGridPtr targetGrid = std::make_shared<FluidSimulations::Grid<FloatType>>(iRes, jRes, kRes);
 
     for (IntegerType i = 0; i != iRes; ++i)
     {
@@ -30,52 +51,102 @@ FluidSimulations::FloatsGridPtr buildGrid(const int iRes, const int jRes, const
 
     return targetGrid;
 }
+#endif
 
-FluidSimulations::FloatsThreeDVectorGridPtr bluildVelocityGrid(const FluidSimulations::IntegersThreeDVector& res)
+FluidSimulations::MacVelocityGridPtr bluildVelocityGrid(const FluidSimulations::IntegersThreeDVector& res)
 {
-    return std::make_shared<FluidSimulations::Grid<FloatsThreeDVector>>(res.x + 1, res.y + 1, res.z + 1, FloatsThreeDVector());
+    return std::make_shared<FluidSimulations::MacVelocityGrid>(res.x, res.y, res.z);
+}
+
+FluidSimulations::IMovementPtr buildCellClassifier(const FluidSimulations::CellFlagsGridPtr& cellFlags,
+    const FluidSdfSpace& sdf, const FloatType solidOffset, const FluidSimulations::TaskSchedulerPtr& scheduler)
+{
+    using namespace FluidSimulations;
+
+    typedef Projection::CellClassificationMovement<FluidPredicate, RigidGridBoundaryPredicate> ClassifierType;
+
+    return std::make_shared<ClassifierType>(cellFlags, FluidPredicate(sdf), RigidGridBoundaryPredicate(cellFlags->res(), solidOffset),
+        scheduler);
 }
 
 FluidSimulations::IMovementPtr buildPressureImposer(const FluidSimulations::IntegersThreeDVector& resolution,
-    const FluidSdfSpace& sdf, const FluidSimulations::FloatsThreeDVectorGridPtr& velocity, const FloatType solidOffset)
+    const FluidSimulations::CellFlagsGridConstPtr& cellFlags, const FluidSimulations::MacVelocityGridPtr& velocity,
+    const FluidSimulations::GridArenaPtr& arena,
+    const FluidSimulations::TaskSchedulerPtr& scheduler,
+    const FluidSimulations::Machinery::StepTimeBudgetPtr& budget)
 {
     using namespace FluidSimulations;
 
+    static_cast<void>(arena);
+    static_cast<void>(budget);
+
+#if defined(FLUID_SIMULATIONS_DEMO_COMPACT_STENCIL)
+    typedef Projection::PressureStencilGrid CoefficientsType;
+#else
+    typedef FloatsFourDVectorGrid CoefficientsType;
+#endif
+
     typedef Projection::GridAllignedPressureSolvePreparator
     <
-            FluidPredicate, RigidGridBoundaryPredicate,
-            AirPredicate<FluidPredicate,
-            RigidGridBoundaryPredicate>,
-            ConstantSpace<FloatsThreeDVector>
+        CellFlagsPredicate, CellFlagsPredicate, CellFlagsPredicate, ConstantSpace<FloatsThreeDVector>, CoefficientsType
     >
     PreparatorType;
 
-    typedef Projection::MiccgZeroSolver<FluidPredicate> SolverType;
+#if defined(FLUID_SIMULATIONS_DEMO_MULTIGRID_SOLVER)
+    typedef Projection::MgpcgSolver SolverType;
+#elif defined(FLUID_SIMULATIONS_DEMO_MIXED_PRECISION_SOLVER)
+    typedef Projection::MixedPrecisionMiccgZeroSolver<CellFlagsPredicate, CoefficientsType> SolverType;
+#elif defined(FLUID_SIMULATIONS_DEMO_PIPELINED_SOLVER)
+    typedef Projection::PipelinedMiccgZeroSolver<CellFlagsPredicate, CoefficientsType> SolverType;
+#elif defined(FLUID_SIMULATIONS_DEMO_DEFLATED_SOLVER)
+    typedef Projection::DeflatedMiccgZeroSolver<CellFlagsPredicate, CoefficientsType> SolverType;
+#elif defined(FLUID_SIMULATIONS_DEMO_COMPONENTS_SOLVER)
+    typedef Projection::ComponentMiccgZeroSolver<CellFlagsPredicate, CoefficientsType> SolverType;
+#elif defined(FLUID_SIMULATIONS_DEMO_PREVIEW_SOLVER)
+    typedef Projection::RedBlackGaussSeidelSolver<CellFlagsPredicate, CoefficientsType> SolverType;
+#elif defined(FLUID_SIMULATIONS_DEMO_EIGEN_SOLVER)
+    typedef Projection::EigenPressureSolver<CellFlagsPredicate, CoefficientsType> SolverType;
+#else
+    typedef Projection::MiccgZeroSolver<CellFlagsPredicate, CoefficientsType> SolverType;
+#endif
 
     typedef Projection::VelocityProjectionMovement
     <
-        FluidPredicate, RigidGridBoundaryPredicate, ConstantSpace<FloatsThreeDVector>
+        CellFlagsPredicate, CellFlagsPredicate, ConstantSpace<FloatsThreeDVector>
     >
     PressureMovementType;
 
-    const FluidPredicate fluidPredicate(sdf);
-    const RigidGridBoundaryPredicate solidPredicate(resolution, solidOffset);
-    const AirPredicate<FluidPredicate, RigidGridBoundaryPredicate> airPredicate(fluidPredicate, solidPredicate);
+    const CellFlagsPredicate fluidPredicate = CellFlagsPredicate::fluid(cellFlags);
+    const CellFlagsPredicate solidPredicate = CellFlagsPredicate::solid(cellFlags);
+    const CellFlagsPredicate airPredicate = CellFlagsPredicate::air(cellFlags);
 
     const FloatType fluidDensity = static_cast<FloatType>(1000);
     const FloatType tolerance = 0.00001f;
     const IntegerType maxIterationsCount = 1000;
+    const bool warmStart = true;
 
     const ConstantSpace<FloatsThreeDVector> solidVelocity(FloatsThreeDVector(0, 0, 0));
 
-    const FloatsFourDVectorGridPtr coefficients = std::make_shared<FloatsFourDVectorGrid>(resolution.x, resolution.y, resolution.z);
+#if defined(FLUID_SIMULATIONS_DEMO_COMPACT_STENCIL)
+    const Projection::PressureStencilGridPtr coefficients = std::make_shared<CoefficientsType>(resolution.x, resolution.y, resolution.z);
+#else
+    const FloatsFourDVectorGridPtr coefficients = std::make_shared<CoefficientsType>(resolution.x, resolution.y, resolution.z, GridHalo(1));
+#endif
     const FloatsGridPtr rhs = std::make_shared<FloatsGrid>(resolution.x, resolution.y, resolution.z);
     const FloatsGridPtr pressure = std::make_shared<FloatsGrid>(resolution.x, resolution.y, resolution.z);
 
     const Projection::IPressureSolverPreparatorPtr coefficientCalculator = std::make_shared<PreparatorType>
         (resolution, velocity, fluidPredicate, solidPredicate, airPredicate, solidVelocity, fluidDensity, coefficients, rhs);
 
-    const Projection::IPressureSolverPtr solver = std::make_shared<SolverType>(pressure, fluidPredicate, coefficients, rhs, tolerance, maxIterationsCount);
+#if defined(FLUID_SIMULATIONS_DEMO_MULTIGRID_SOLVER)
+    const Projection::IPressureSolverPtr solver = std::make_shared<SolverType>(pressure, cellFlags, coefficients, rhs, tolerance, maxIterationsCount, arena, scheduler, warmStart);
+#elif defined(FLUID_SIMULATIONS_DEMO_PREVIEW_SOLVER)
+    const Projection::IPressureSolverPtr solver = std::make_shared<SolverType>(pressure, fluidPredicate, coefficients, rhs, tolerance, maxIterationsCount, arena, scheduler, warmStart, budget);
+#elif defined(FLUID_SIMULATIONS_DEMO_EIGEN_SOLVER)
+    const Projection::IPressureSolverPtr solver = std::make_shared<SolverType>(pressure, fluidPredicate, coefficients, rhs, tolerance, maxIterationsCount, scheduler, warmStart);
+#else
+    const Projection::IPressureSolverPtr solver = std::make_shared<SolverType>(pressure, fluidPredicate, coefficients, rhs, tolerance, maxIterationsCount, arena, scheduler, warmStart);
+#endif
 
     return std::make_shared<PressureMovementType>(velocity, pressure, fluidPredicate, solidPredicate, solidVelocity, fluidDensity,
         coefficientCalculator, solver);
@@ -85,9 +156,11 @@ FluidSimulations::IMovementPtr buildPressureImposer(const FluidSimulations::Inte
 
 AquariumFluidSystem::AquariumFluidSystem(
     const FluidSdfSpace& fluidSdf,
-    const FluidSimulations::ISimulatorPtr& simulator)
+    const FluidSimulations::ISimulatorPtr& simulator,
+    const FluidSimulations::Machinery::StepTimeBudgetPtr& stepBudget)
     : m_fluidSdf(fluidSdf)
     , m_simulator(simulator)
+    , m_stepBudget(stepBudget)
 {
 }
 
@@ -101,9 +174,12 @@ std::shared_ptr<AquariumFluidSystem> AquariumFluidSystem::build(const int iRes,
 
     const FloatType solidOffset = 2.4f;
 
+    const GridArenaPtr arena = std::make_shared<GridArena>();
+    const TaskSchedulerPtr scheduler = std::make_shared<TaskScheduler>();
+
     const auto fluidSdfGrid = buildGrid(iRes, jRes, kRes, sdf);
-    const auto fluidSdfInternalSpace = LinearFloatsGridApproximator(fluidSdfGrid);
-    const auto fluidSdfSpace = SignedDistanceGridApproximatorExtension<LinearFloatsGridApproximator>::wrapSignedDistance(
+    const auto fluidSdfInternalSpace = InternalFluidSdfSpace(fluidSdfGrid);
+    const auto fluidSdfSpace = SignedDistanceGridApproximatorExtension<InternalFluidSdfSpace>::wrapSignedDistance(
         fluidSdfInternalSpace, fluidSdfGrid->res(), solidOffset);
 
     const auto fluidInteriorPredicate = InteriorPredicate<FluidSdfSpace>(fluidSdfSpace);
@@ -112,36 +188,48 @@ std::shared_ptr<AquariumFluidSystem> AquariumFluidSystem::build(const int iRes,
     const auto velocityGrid = bluildVelocityGrid(fluidSdfGrid->res());
     const auto internalVelocitySpace = InternalVelocitySpace(
         velocityGrid, fluidInteriorPredicate, nearesSurfacePointCalculator);
-    const auto velocitySpace = borderVelocity<InternalVelocitySpace>(internalVelocitySpace, velocityGrid->res(), solidOffset);
+    const auto velocitySpace = borderVelocity<InternalVelocitySpace>(internalVelocitySpace, sum(velocityGrid->res(), 1), solidOffset);
 
     const auto lagrangeTracker = RungeKuttaLagrangeTracker<VelocitySpace>(velocitySpace);
 
-    const IMovementPtr fluidSdfAdvector = std::make_shared<LagrangeFieldAdvector<FluidSdfSpace, RungeKuttaLagrangeTracker<VelocitySpace>>>(
-        fluidSdfGrid, fluidSdfSpace, lagrangeTracker);
+    const IMovementPtr fluidSdfAdvector = std::make_shared<LagrangeFieldAdvector<FluidSdfSpace, RungeKuttaLagrangeTracker<VelocitySpace>, FluidSdfGrid>>(
+        fluidSdfGrid, fluidSdfSpace, lagrangeTracker, arena, scheduler);
 
     const IMovementPtr fluidSdfMovement = std::make_shared<SignedDistanceField::SignedDistanceMovement>(
-        fluidSdfAdvector, std::make_shared<SignedDistanceField::SignedDistanceSweeper<FluidSdfSpace>>(fluidSdfGrid, fluidSdfSpace));
+        fluidSdfAdvector, std::make_shared<SignedDistanceField::SignedDistanceSweeper<FluidSdfSpace, FluidSdfGrid>>(
+            fluidSdfGrid, fluidSdfSpace, narrowBandWidth, arena));
 
     // TODO VS warning c4503
     const IMovementPtr velocityAdvector = std::make_shared<LagrangeVelocityAdvector<VelocitySpace, RungeKuttaLagrangeTracker<VelocitySpace>>>(
-        velocityGrid, velocitySpace, lagrangeTracker);
+        velocityGrid, velocitySpace, lagrangeTracker, arena, scheduler);
 
     const IMovementPtr gravitaionAdvector = std::make_shared<ConstantSpaceForceAccelerator>(velocityGrid, 
-        std::make_shared<FloatsThreeDVector>(0, -gravitationAcceleration, 0));
+        std::make_shared<FloatsThreeDVector>(0, -gravitationAcceleration, 0), scheduler);
 
-    const IMovementPtr pressureAdvector = buildPressureImposer(fluidSdfGrid->res(), fluidSdfSpace, velocityGrid, solidOffset);
+    const CellFlagsGridPtr cellFlags = std::make_shared<CellFlagsGrid>(iRes, jRes, kRes, GridHalo(1));
+
+    const IMovementPtr cellClassifier = buildCellClassifier(cellFlags, fluidSdfSpace, solidOffset, scheduler);
+
+#ifdef FLUID_SIMULATIONS_DEMO_PREVIEW_SOLVER
+    const Machinery::StepTimeBudgetPtr budget = std::make_shared<Machinery::StepTimeBudget>(previewStepSeconds);
+#else
+    const Machinery::StepTimeBudgetPtr budget;
+#endif
+
+    const IMovementPtr pressureAdvector = buildPressureImposer(fluidSdfGrid->res(), cellFlags, velocityGrid, arena, scheduler, budget);
 
     std::vector<IMovementPtr> movements;
     movements.push_back(fluidSdfMovement);
     movements.push_back(velocityAdvector);
     movements.push_back(gravitaionAdvector);
+    movements.push_back(cellClassifier);
     movements.push_back(pressureAdvector);
 
-    const Machinery::ITimeSuggesterConstPtr cflTimeSuggester = std::make_shared<Machinery::CflConditionTimeSuggester>(velocityGrid, gravitationAcceleration);
+    const Machinery::ITimeSuggesterConstPtr cflTimeSuggester = std::make_shared<Machinery::CflConditionTimeSuggester>(velocityGrid, gravitationAcceleration, scheduler);
 
-    const ISimulatorPtr simulator = std::make_shared<Machinery::ConstantTimeSimulator>(cflTimeSuggester, movements, timeInterval);
+    const ISimulatorPtr simulator = std::make_shared<Machinery::ConstantTimeSimulator>(cflTimeSuggester, movements, timeInterval, scheduler, budget);
 
-    return (std::shared_ptr<AquariumFluidSystem>) new AquariumFluidSystem(fluidSdfSpace, simulator);
+    return (std::shared_ptr<AquariumFluidSystem>) new AquariumFluidSystem(fluidSdfSpace, simulator, budget);
 }
 
 const FluidSdfSpace& AquariumFluidSystem::fluidSdf() const
@@ -154,4 +242,9 @@ const FluidSimulations::ISimulatorPtr AquariumFluidSystem::simulator() const
     return m_simulator;
 }
 
+const FluidSimulations::Machinery::StepTimeBudgetPtr AquariumFluidSystem::stepBudget() const
+{
+    return m_stepBudget;
+}
+
 }
\ No newline at end of file
@@ -21,15 +21,21 @@ public:
     const FluidSdfSpace& fluidSdf() const;
 
     const FluidSimulations::ISimulatorPtr simulator() const;
+
+    // The time budget of the steps of the preview solver, null for the other solvers.
+
+    const FluidSimulations::Machinery::StepTimeBudgetPtr stepBudget() const;
     
 private:
     AquariumFluidSystem(
         const FluidSdfSpace& fluidSdf,
-        const FluidSimulations::ISimulatorPtr& simulator);
+        const FluidSimulations::ISimulatorPtr& simulator,
+        const FluidSimulations::Machinery::StepTimeBudgetPtr& stepBudget);
 
 private:
     const FluidSdfSpace m_fluidSdf;
     const FluidSimulations::ISimulatorPtr m_simulator;
+    const FluidSimulations::Machinery::StepTimeBudgetPtr m_stepBudget;
     
 };
 
@@ -14,7 +14,15 @@ typedef std::function
 > 
 FloatSpaceFunctor;
 
-typedef FluidSimulations::LinearFloatsGridApproximator InternalFluidSdfSpace;
+#ifdef FLUID_SIMULATIONS_DEMO_SPARSE_SDF
+typedef FluidSimulations::SparseFloatsGrid FluidSdfGrid;
+#else
+typedef FluidSimulations::FloatsGrid FluidSdfGrid;
+#endif
+
+typedef std::shared_ptr<FluidSdfGrid> FluidSdfGridPtr;
+
+typedef FluidSimulations::LinearGridApproximator<FluidSdfGrid> InternalFluidSdfSpace;
 
 typedef FluidSimulations::RigidGridBoundary
 <